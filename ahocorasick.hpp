@@ -0,0 +1,449 @@
+#ifndef __AHOCORASICK_HPP_2026_10_17__
+#define __AHOCORASICK_HPP_2026_10_17__
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fsm.hpp"
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    // recognizes trees which are alternations of plain strings
+    template <class TChar>
+    class TLiteralSetAnalyzer
+    {
+    public:
+        typedef std::basic_string<TChar> TString;
+        // literal and id of the pattern it came from
+        typedef std::vector<std::pair<TString, unsigned> > TLiterals;
+
+        // appends literals matched by tree to result, returns false and
+        // leaves result unspecified if tree is not a literal set
+        static bool GetLiterals(const INode* root, unsigned pattern,
+            TLiterals& result)
+        {
+            // alternation branches, left to right
+            std::vector<const INode*> branches(1, root);
+            // concatenation operands, left to right
+            std::vector<const INode*> operands;
+            while(!branches.empty())
+            {
+                const INode* branch = branches.back();
+                branches.pop_back();
+                if(branch->GetNodeType() == TNodeType::Operation)
+                {
+                    // groups do not change matched strings
+                    const IOperation* operation =
+                        static_cast<const IOperation*>(branch);
+                    const TOperationType::TType type =
+                        operation->GetOperationType();
+                    if(type == TOperationType::Capture)
+                    {
+                        branches.push_back(operation->Children[0]);
+                        continue;
+                    }
+                    if(type == TOperationType::Alternation)
+                    {
+                        branches.push_back(operation->Children[1]);
+                        branches.push_back(operation->Children[0]);
+                        continue;
+                    }
+                }
+
+                result.push_back(std::make_pair(TString(), pattern));
+                operands.push_back(branch);
+                while(!operands.empty())
+                {
+                    const INode* node = operands.back();
+                    operands.pop_back();
+                    if(node->GetNodeType() == TNodeType::Token)
+                    {
+                        const TTokenType::TType type =
+                            static_cast<const IToken*>(node)->GetTokenType();
+                        if(type == TTokenType::Character)
+                        {
+                            result.back().first.push_back(static_cast<
+                                const TCharacter<TChar>*>(node)->Character);
+                        }
+                        else if(type == TTokenType::Class)
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+                    const IOperation* operation =
+                        static_cast<const IOperation*>(node);
+                    if(operation->GetOperationType()
+                        == TOperationType::Capture)
+                    {
+                        operands.push_back(operation->Children[0]);
+                        continue;
+                    }
+                    if(operation->GetOperationType()
+                        != TOperationType::Concatenation)
+                    {
+                        return false;
+                    }
+                    operands.push_back(operation->Children[1]);
+                    operands.push_back(operation->Children[0]);
+                }
+            }
+            return true;
+        }
+
+        // literals of all trees, pattern id is tree index
+        static bool GetLiterals(const std::vector<const INode*>& roots,
+            TLiterals& result)
+        {
+            for(unsigned pattern = 0; pattern < roots.size(); ++pattern)
+            {
+                if(!GetLiterals(roots[pattern], pattern, result))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Aho-Corasick automaton stored as a double-array trie over byte
+    // classes plus failure links, memory is linear in the total literals
+    // length, so it is cheap to build for huge dictionaries
+    // behaves like TDFA created unanchored: it accepts after every prefix
+    // ending with one of the literals and is never dead, so it works with
+    // SearchDFA, SearchPatternsDFA and TDFAStepper
+    template <class TChar>
+    class TAhoCorasick
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        static const unsigned Free = static_cast<unsigned>(-1);
+
+        TAlphabet Alphabet;
+        // state s has transition on symbol a to Base[s] + a if
+        // Check[Base[s] + a] is s, Check is long enough to never overflow
+        std::vector<unsigned> Base;
+        std::vector<unsigned> Check;
+        // the longest proper suffix of state string which is a trie state
+        std::vector<unsigned> Fail;
+        // bitmap, one bit per state
+        std::vector<unsigned> AcceptStates;
+
+    public:
+        typedef std::vector<unsigned> TPatterns;
+
+    private:
+        // patterns of literals which are suffixes of state string, ordered
+        std::vector<unsigned> PatternOffsets;
+        TPatterns AcceptPatterns;
+
+        // sorted literals trie, children of a node are added in ascending
+        // order, so sibling lists are sorted
+        struct TTrie
+        {
+            std::vector<unsigned> FirstChild;
+            std::vector<unsigned> LastChild;
+            std::vector<unsigned> NextSibling;
+            std::vector<unsigned char> Symbol;
+
+            inline TTrie()
+                : FirstChild(1, 0)
+                , LastChild(1, 0)
+                , NextSibling(1, 0)
+                , Symbol(1, 0)
+            {
+            }
+
+            // 0 is the root, so it never is a child
+            inline unsigned AddChild(unsigned node, unsigned char symbol)
+            {
+                const unsigned child = FirstChild.size();
+                FirstChild.push_back(0);
+                LastChild.push_back(0);
+                NextSibling.push_back(0);
+                Symbol.push_back(symbol);
+                if(LastChild[node])
+                {
+                    NextSibling[LastChild[node]] = child;
+                }
+                else
+                {
+                    FirstChild[node] = child;
+                }
+                LastChild[node] = child;
+                return child;
+            }
+        };
+
+        inline unsigned Goto(unsigned state, unsigned symbol) const
+        {
+            const unsigned target = Base[state] + symbol;
+            return Check[target] == state ? target : Free;
+        }
+
+        inline void SetAccept(unsigned state)
+        {
+            AcceptStates[state / (sizeof(unsigned) * CHAR_BIT)] |=
+                1u << (state % (sizeof(unsigned) * CHAR_BIT));
+        }
+
+        // places trie into double array, returns trie nodes in breadth
+        // first order with their states
+        void Place(const TTrie& trie,
+            std::vector<std::pair<unsigned, unsigned> >& order)
+        {
+            const unsigned classes = Alphabet.ClassesCount;
+            // the first index which may be free
+            unsigned hint = StartState + 1;
+            std::vector<unsigned> symbols;
+            order.push_back(std::make_pair(0u, unsigned(StartState)));
+            for(std::vector<std::pair<unsigned, unsigned> >::size_type
+                current = 0; current < order.size(); ++current)
+            {
+                const unsigned node = order[current].first;
+                const unsigned state = order[current].second;
+                symbols.clear();
+                for(unsigned child = trie.FirstChild[node]; child;
+                    child = trie.NextSibling[child])
+                {
+                    symbols.push_back(Alphabet[trie.Symbol[child]]);
+                }
+                if(symbols.empty())
+                {
+                    continue;
+                }
+
+                while(hint < Check.size() && Check[hint] != Free)
+                {
+                    ++hint;
+                }
+                // the smallest base putting the first child to a free slot
+                // not below hint
+                unsigned base = hint > symbols.front()
+                    ? hint - symbols.front() : 0;
+                for(bool placed = false; !placed; ++base)
+                {
+                    if(Check.size() < base + classes)
+                    {
+                        Check.resize(base + classes, Free);
+                    }
+                    placed = true;
+                    for(std::vector<unsigned>::const_iterator symbol =
+                        symbols.begin(), end = symbols.end();
+                        symbol != end && placed; ++symbol)
+                    {
+                        placed = base + *symbol > StartState
+                            && Check[base + *symbol] == Free;
+                    }
+                }
+                --base;
+
+                Base[state] = base;
+                unsigned child = trie.FirstChild[node];
+                for(std::vector<unsigned>::const_iterator symbol =
+                    symbols.begin(), end = symbols.end(); symbol != end;
+                    ++symbol, child = trie.NextSibling[child])
+                {
+                    Check[base + *symbol] = state;
+                    order.push_back(std::make_pair(child, base + *symbol));
+                }
+                if(Base.size() < Check.size())
+                {
+                    Base.resize(Check.size(), 0);
+                }
+            }
+        }
+
+    public:
+        enum
+        {
+            // never reached, present for compatibility with TDFA
+            DeadState = 0,
+            StartState = 1
+        };
+
+        // empty literal makes every state accepting
+        TAhoCorasick(
+            const typename TLiteralSetAnalyzer<TChar>::TLiterals& literals)
+        {
+            typename TLiteralSetAnalyzer<TChar>::TLiterals sorted(literals);
+            std::sort(sorted.begin(), sorted.end());
+
+            // trie node of every prefix of the previous literal
+            std::vector<unsigned> path(1, 0);
+            // (trie node, pattern) pairs
+            std::vector<std::pair<unsigned, unsigned> > terminals;
+            TTrie trie;
+            for(typename TLiteralSetAnalyzer<TChar>::TLiterals::
+                const_iterator literal = sorted.begin(), end = sorted.end();
+                literal != end; ++literal)
+            {
+                const std::basic_string<TChar>& string = literal->first;
+                unsigned common = 0;
+                if(literal != sorted.begin())
+                {
+                    const std::basic_string<TChar>& previous =
+                        (literal - 1)->first;
+                    while(common < string.size()
+                        && common < previous.size()
+                        && string[common] == previous[common])
+                    {
+                        ++common;
+                    }
+                }
+                path.resize(common + 1);
+                for(unsigned i = common; i < string.size(); ++i)
+                {
+                    Alphabet.AddRange(string[i], string[i]);
+                    path.push_back(trie.AddChild(path.back(),
+                        static_cast<unsigned char>(string[i])));
+                }
+                terminals.push_back(std::make_pair(path.back(),
+                    literal->second));
+            }
+
+            Base.assign(StartState + 1, 0);
+            Check.assign(StartState + 1, Free);
+            std::vector<std::pair<unsigned, unsigned> > order;
+            Place(trie, order);
+            const unsigned count = Check.size();
+
+            // patterns of every trie node itself
+            std::vector<unsigned> stateOf(trie.FirstChild.size());
+            for(std::vector<std::pair<unsigned, unsigned> >::const_iterator
+                node = order.begin(), end = order.end(); node != end;
+                ++node)
+            {
+                stateOf[node->first] = node->second;
+            }
+            std::vector<std::pair<unsigned, unsigned> > own;
+            for(std::vector<std::pair<unsigned, unsigned> >::const_iterator
+                terminal = terminals.begin(), end = terminals.end();
+                terminal != end; ++terminal)
+            {
+                own.push_back(std::make_pair(stateOf[terminal->first],
+                    terminal->second));
+            }
+            std::sort(own.begin(), own.end());
+
+            // failure links and accepted patterns in breadth first order,
+            // so links of shorter strings are always ready, patterns are
+            // collected in the breadth first order and reordered by state
+            // afterwards
+            Fail.assign(count, StartState);
+            AcceptStates.assign((count + sizeof(unsigned) * CHAR_BIT - 1)
+                / (sizeof(unsigned) * CHAR_BIT), 0);
+            std::vector<unsigned> first(count, 0);
+            std::vector<unsigned> last(count, 0);
+            std::vector<unsigned> patterns;
+            for(std::vector<std::pair<unsigned, unsigned> >::const_iterator
+                node = order.begin(), end = order.end(); node != end;
+                ++node)
+            {
+                const unsigned state = node->second;
+                if(state != StartState)
+                {
+                    const unsigned parent = Check[state];
+                    const unsigned symbol = state - Base[parent];
+                    for(unsigned link = parent; link != StartState;)
+                    {
+                        link = Fail[link];
+                        const unsigned target = Goto(link, symbol);
+                        if(target != Free)
+                        {
+                            Fail[state] = target;
+                            break;
+                        }
+                    }
+                }
+
+                first[state] = patterns.size();
+                for(std::vector<std::pair<unsigned, unsigned> >::
+                    const_iterator pattern = std::lower_bound(own.begin(),
+                        own.end(), std::make_pair(state, 0u));
+                    pattern != own.end() && pattern->first == state;
+                    ++pattern)
+                {
+                    patterns.push_back(pattern->second);
+                }
+                if(state != StartState)
+                {
+                    const unsigned link = Fail[state];
+                    for(unsigned i = first[link]; i < last[link]; ++i)
+                    {
+                        patterns.push_back(patterns[i]);
+                    }
+                }
+                std::sort(patterns.begin() + first[state], patterns.end());
+                patterns.erase(std::unique(patterns.begin() + first[state],
+                    patterns.end()), patterns.end());
+                last[state] = patterns.size();
+                if(first[state] != last[state])
+                {
+                    SetAccept(state);
+                }
+            }
+
+            PatternOffsets.push_back(0);
+            for(unsigned state = 0; state < count; ++state)
+            {
+                AcceptPatterns.insert(AcceptPatterns.end(),
+                    patterns.begin() + first[state],
+                    patterns.begin() + last[state]);
+                PatternOffsets.push_back(AcceptPatterns.size());
+            }
+        }
+
+        inline unsigned Next(unsigned state, TChar character) const
+        {
+            const unsigned symbol =
+                Alphabet[static_cast<unsigned char>(character)];
+            for(;;)
+            {
+                const unsigned target = Base[state] + symbol;
+                if(Check[target] == state)
+                {
+                    return target;
+                }
+                if(state == StartState)
+                {
+                    return StartState;
+                }
+                state = Fail[state];
+            }
+        }
+
+        inline bool IsAccept(unsigned state) const
+        {
+            return AcceptStates[state / (sizeof(unsigned) * CHAR_BIT)]
+                >> (state % (sizeof(unsigned) * CHAR_BIT)) & 1;
+        }
+
+        inline typename TPatterns::const_iterator PatternsBegin(
+            unsigned state) const
+        {
+            return AcceptPatterns.begin() + PatternOffsets[state];
+        }
+
+        inline typename TPatterns::const_iterator PatternsEnd(
+            unsigned state) const
+        {
+            return AcceptPatterns.begin() + PatternOffsets[state + 1];
+        }
+
+        // double array length, including unused slots
+        inline unsigned StatesCount() const
+        {
+            return Check.size();
+        }
+    };
+
+    template <class TChar>
+    const unsigned TAhoCorasick<TChar>::Free;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef __ALPHABETGENERATOR_HPP_2026_10_17__
+#define __ALPHABETGENERATOR_HPP_2026_10_17__
+
+#include <vector>
+
+#include "fsm.hpp"
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    template <class TChar>
+    class TAlphabetGenerator
+    {
+        // byte classes are only defined for byte sized characters
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        static void AddCharacters(TAlphabet& result, const INode* root)
+        {
+            std::vector<const INode*> stack(1, root);
+            while(!stack.empty())
+            {
+                const INode* node = stack.back();
+                stack.pop_back();
+                if(node->GetNodeType() == TNodeType::Operation)
+                {
+                    const IOperation* operation =
+                        static_cast<const IOperation*>(node);
+                    for(unsigned i = 0; i < 2; ++i)
+                    {
+                        if(operation->Children[i])
+                        {
+                            stack.push_back(operation->Children[i]);
+                        }
+                    }
+                }
+                else if(static_cast<const IToken*>(node)->GetTokenType()
+                    == TTokenType::Character)
+                {
+                    const TChar character = static_cast<
+                        const TCharacter<TChar>*>(node)->Character;
+                    result.AddRange(character, character);
+                }
+                else if(static_cast<const IToken*>(node)->GetTokenType()
+                    == TTokenType::Class)
+                {
+                    const TCharacterClass<TChar>* characterClass =
+                        static_cast<const TCharacterClass<TChar>*>(node);
+                    for(const typename TCharacterClass<TChar>::TRange*
+                        range = characterClass->Begin(),
+                        *end = characterClass->End(); range != end; ++range)
+                    {
+                        result.AddRange(range->first, range->second);
+                    }
+                }
+            }
+        }
+
+    public:
+        // every character met in the tree gets its own class, every class
+        // range is a union of classes, all other bytes share the remaining
+        // one
+        static inline TAlphabet CreateAlphabet(const INode* root)
+        {
+            TAlphabet result;
+            AddCharacters(result, root);
+            return result;
+        }
+
+        // alphabet suitable for all of the trees
+        static TAlphabet CreateAlphabet(
+            const std::vector<const INode*>& roots)
+        {
+            TAlphabet result;
+            for(std::vector<const INode*>::const_iterator root =
+                roots.begin(), end = roots.end(); root != end; ++root)
+            {
+                AddCharacters(result, *root);
+            }
+            return result;
+        }
+    };
+}
+
+#endif
+
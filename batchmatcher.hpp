@@ -0,0 +1,305 @@
+#ifndef __BATCHMATCHER_HPP_2026_10_17__
+#define __BATCHMATCHER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "dfamatcher.hpp"
+
+namespace NReinventedWheels
+{
+    // one record of a batch, [Begin, End) range
+    struct TRecord
+    {
+        const char* Begin;
+        const char* End;
+    };
+
+    // per worker scratch, reused between batches, so matching does not
+    // allocate once buffers have grown
+    struct TMatchScratch
+    {
+        // ids of matched records, ascending within every taken range
+        std::vector<unsigned> Matches;
+        // keeps scratches of different workers on different cache lines
+        char Padding[64];
+    };
+
+    // matches batches of records against one automaton using a pool of
+    // threads, automaton is only accessed through its const interface, so
+    // it is shared by all of them, while all mutable state is per worker
+    // records are spread over workers in ranges, a worker which runs out
+    // of its own range steals half of somebody else's, ranges are changed
+    // by a single compare and swap, so matching takes no locks, they are
+    // only taken to start and finish a batch
+    template <class TAutomaton>
+    class TBatchMatcher
+    {
+        // records taken from own range at a time
+        enum
+        {
+            Grain = 64
+        };
+
+        // not yet taken records, begin in high half, end in low half
+        // vector aligns elements to 16 bytes only, so ranges take 128
+        // bytes to never share a 64 byte cache line
+        struct TRange
+        {
+            volatile uint64_t Bounds;
+            char Padding[128 - sizeof(uint64_t)];
+        };
+
+        struct TWorker
+        {
+            TBatchMatcher* Matcher;
+            unsigned Index;
+        };
+
+        const TAutomaton& Automaton;
+        const bool Anchored;
+        std::vector<TRange> Ranges;
+        std::vector<TMatchScratch> Scratches;
+        std::vector<TWorker> Workers;
+        std::vector<pthread_t> Threads;
+        const TRecord* Records;
+
+        pthread_mutex_t Mutex;
+        pthread_cond_t Started;
+        pthread_cond_t Finished;
+        unsigned Generation;
+        unsigned Pending;
+        bool Stopping;
+
+        static inline uint64_t Pack(unsigned begin, unsigned end)
+        {
+            return static_cast<uint64_t>(begin) << 32 | end;
+        }
+
+        // bounds are changed by other threads, so they are read
+        // atomically
+        static inline uint64_t Load(const TRange& range)
+        {
+            return __atomic_load_n(&range.Bounds, __ATOMIC_ACQUIRE);
+        }
+
+        // takes some records from the front of the range
+        bool Take(TRange& range, unsigned& begin, unsigned& end)
+        {
+            for(;;)
+            {
+                const uint64_t bounds = Load(range);
+                begin = bounds >> 32;
+                end = static_cast<unsigned>(bounds);
+                if(begin >= end)
+                {
+                    return false;
+                }
+                const unsigned taken = std::min<unsigned>(begin + Grain,
+                    end);
+                if(__sync_bool_compare_and_swap(&range.Bounds, bounds,
+                    Pack(taken, end)))
+                {
+                    end = taken;
+                    return true;
+                }
+            }
+        }
+
+        // moves the back half of some other worker range to own range
+        bool Steal(unsigned index)
+        {
+            const unsigned count = Ranges.size();
+            for(unsigned i = 1; i < count; ++i)
+            {
+                TRange& victim = Ranges[(index + i) % count];
+                for(;;)
+                {
+                    const uint64_t bounds = Load(victim);
+                    const unsigned begin = bounds >> 32;
+                    const unsigned end = static_cast<unsigned>(bounds);
+                    if(begin >= end)
+                    {
+                        break;
+                    }
+                    const unsigned middle = begin + (end - begin) / 2;
+                    if(__sync_bool_compare_and_swap(&victim.Bounds, bounds,
+                        Pack(begin, middle)))
+                    {
+                        // own range is empty, so nobody else changes it
+                        __sync_lock_test_and_set(&Ranges[index].Bounds,
+                            Pack(middle, end));
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void Work(unsigned index)
+        {
+            std::vector<unsigned>& matches = Scratches[index].Matches;
+            matches.clear();
+            unsigned begin;
+            unsigned end;
+            do
+            {
+                while(Take(Ranges[index], begin, end))
+                {
+                    for(; begin != end; ++begin)
+                    {
+                        const TRecord& record = Records[begin];
+                        const char* matchEnd;
+                        if(Anchored
+                            ? MatchDFA(Automaton, record.Begin, record.End)
+                            : SearchDFA(Automaton, record.Begin, record.End,
+                                matchEnd))
+                        {
+                            matches.push_back(begin);
+                        }
+                    }
+                }
+            }
+            while(Steal(index));
+        }
+
+        static void* Run(void* data)
+        {
+            const TWorker& worker = *static_cast<TWorker*>(data);
+            TBatchMatcher& matcher = *worker.Matcher;
+            unsigned generation = 0;
+            pthread_mutex_lock(&matcher.Mutex);
+            for(;;)
+            {
+                while(matcher.Generation == generation && !matcher.Stopping)
+                {
+                    pthread_cond_wait(&matcher.Started, &matcher.Mutex);
+                }
+                if(matcher.Stopping)
+                {
+                    break;
+                }
+                generation = matcher.Generation;
+                pthread_mutex_unlock(&matcher.Mutex);
+                matcher.Work(worker.Index);
+                pthread_mutex_lock(&matcher.Mutex);
+                if(!--matcher.Pending)
+                {
+                    pthread_cond_signal(&matcher.Finished);
+                }
+            }
+            pthread_mutex_unlock(&matcher.Mutex);
+            return 0;
+        }
+
+        TBatchMatcher(const TBatchMatcher&);
+        TBatchMatcher& operator = (const TBatchMatcher&);
+
+    public:
+        // anchored automaton matches whole records, otherwise automaton
+        // must be unanchored and records containing a match are reported
+        // the calling thread is one of workers, fewer threads are used if
+        // they can not be created
+        TBatchMatcher(const TAutomaton& automaton, bool anchored,
+            unsigned workers)
+            : Automaton(automaton)
+            , Anchored(anchored)
+            , Ranges(std::max(workers, 1u))
+            , Scratches(Ranges.size())
+            , Workers(Ranges.size())
+            , Records(0)
+            , Generation(0)
+            , Pending(0)
+            , Stopping(false)
+        {
+            pthread_mutex_init(&Mutex, 0);
+            pthread_cond_init(&Started, 0);
+            pthread_cond_init(&Finished, 0);
+            for(unsigned i = 0; i < Workers.size(); ++i)
+            {
+                Ranges[i].Bounds = 0;
+                Workers[i].Matcher = this;
+                Workers[i].Index = i;
+            }
+            for(unsigned i = 1; i < Workers.size(); ++i)
+            {
+                pthread_t thread;
+                if(pthread_create(&thread, 0, &Run, &Workers[i]))
+                {
+                    break;
+                }
+                Threads.push_back(thread);
+            }
+            // vectors only shrink, so started threads keep their data
+            Ranges.resize(Threads.size() + 1);
+            Scratches.resize(Ranges.size());
+        }
+
+        ~TBatchMatcher()
+        {
+            pthread_mutex_lock(&Mutex);
+            Stopping = true;
+            pthread_cond_broadcast(&Started);
+            pthread_mutex_unlock(&Mutex);
+            for(unsigned i = 0; i < Threads.size(); ++i)
+            {
+                pthread_join(Threads[i], 0);
+            }
+            pthread_cond_destroy(&Finished);
+            pthread_cond_destroy(&Started);
+            pthread_mutex_destroy(&Mutex);
+        }
+
+        inline unsigned WorkersCount() const
+        {
+            return Ranges.size();
+        }
+
+        // ids of records matched by worker during the last batch
+        inline const std::vector<unsigned>& GetMatches(unsigned worker) const
+        {
+            return Scratches[worker].Matches;
+        }
+
+        // matches records, results are available through GetMatches until
+        // the next batch, batch must be shorter than 2^32 records
+        // returns number of matched records
+        unsigned MatchBatch(const TRecord* records, unsigned count)
+        {
+            Records = records;
+            const unsigned workers = Ranges.size();
+            for(unsigned i = 0; i < workers; ++i)
+            {
+                Ranges[i].Bounds = Pack(static_cast<unsigned>(
+                    static_cast<uint64_t>(count) * i / workers),
+                    static_cast<unsigned>(
+                        static_cast<uint64_t>(count) * (i + 1) / workers));
+            }
+            pthread_mutex_lock(&Mutex);
+            ++Generation;
+            Pending = Threads.size();
+            pthread_cond_broadcast(&Started);
+            pthread_mutex_unlock(&Mutex);
+
+            Work(0);
+
+            pthread_mutex_lock(&Mutex);
+            while(Pending)
+            {
+                pthread_cond_wait(&Finished, &Mutex);
+            }
+            pthread_mutex_unlock(&Mutex);
+            unsigned matched = 0;
+            for(unsigned i = 0; i < workers; ++i)
+            {
+                matched += Scratches[i].Matches.size();
+            }
+            return matched;
+        }
+    };
+}
+
+#endif
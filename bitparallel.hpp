@@ -0,0 +1,275 @@
+#ifndef __BITPARALLEL_HPP_2026_10_17__
+#define __BITPARALLEL_HPP_2026_10_17__
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+
+#include <stdint.h>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // 128 bit state mask for the two words variant
+    struct TDoubleWord
+    {
+        uint64_t Low;
+        uint64_t High;
+
+        inline TDoubleWord(uint64_t low = 0, uint64_t high = 0)
+            : Low(low)
+            , High(high)
+        {
+        }
+
+        inline TDoubleWord operator & (const TDoubleWord& other) const
+        {
+            return TDoubleWord(Low & other.Low, High & other.High);
+        }
+
+        inline TDoubleWord operator | (const TDoubleWord& other) const
+        {
+            return TDoubleWord(Low | other.Low, High | other.High);
+        }
+
+        inline TDoubleWord& operator |= (const TDoubleWord& other)
+        {
+            Low |= other.Low;
+            High |= other.High;
+            return *this;
+        }
+
+        inline bool operator ! () const
+        {
+            return !(Low | High);
+        }
+
+        inline bool operator != (const TDoubleWord& other) const
+        {
+            return Low != other.Low || High != other.High;
+        }
+    };
+
+    inline unsigned char GetMaskByte(uint64_t mask, unsigned index)
+    {
+        return mask >> index * CHAR_BIT;
+    }
+
+    inline unsigned char GetMaskByte(const TDoubleWord& mask, unsigned index)
+    {
+        return index < sizeof(uint64_t)
+            ? GetMaskByte(mask.Low, index)
+            : GetMaskByte(mask.High, index - sizeof(uint64_t));
+    }
+
+    inline void SetMaskBit(uint64_t& mask, unsigned bit)
+    {
+        mask |= static_cast<uint64_t>(1) << bit;
+    }
+
+    inline void SetMaskBit(TDoubleWord& mask, unsigned bit)
+    {
+        if(bit < sizeof(uint64_t) * CHAR_BIT)
+        {
+            SetMaskBit(mask.Low, bit);
+        }
+        else
+        {
+            SetMaskBit(mask.High, bit - sizeof(uint64_t) * CHAR_BIT);
+        }
+    }
+
+    // simulates NFA with one bit per state, applicable to automata where all
+    // transitions into a state consume the same character, which holds for
+    // everything TNFAGenerator produces
+    // a step is next = Follow(current) & Entered[character], where Follow is
+    // looked up by each byte of the current mask
+    template <class TChar, class TMask = uint64_t>
+    class TBitParallelMatcher
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        enum
+        {
+            MaxStates = sizeof(TMask) * CHAR_BIT,
+            ByteValues = UCHAR_MAX + 1
+        };
+
+        // number of mask bytes in use
+        unsigned Chunks;
+        // Chunks tables of ByteValues masks, successors of states set in
+        // the corresponding byte of the current mask
+        std::vector<TMask> Follow;
+        // states entered by each character
+        TMask Entered[ByteValues];
+        TMask AcceptStates;
+        TMask Current;
+
+        // throws before any tables are allocated if nfa does not fit
+        static unsigned GetChunks(const TNFA<TChar>& nfa)
+        {
+            if(nfa.StatesCount() > MaxStates)
+            {
+                throw std::logic_error(
+                    "too many states for bit-parallel matcher");
+            }
+            return (nfa.StatesCount() + CHAR_BIT - 1) / CHAR_BIT;
+        }
+
+    public:
+        TBitParallelMatcher(const TNFA<TChar>& nfa)
+            : Chunks(GetChunks(nfa))
+            , Follow(Chunks * ByteValues)
+            , AcceptStates()
+            , Current()
+        {
+            const unsigned states = nfa.StatesCount();
+            std::fill(Entered, Entered + ByteValues, TMask());
+
+            std::vector<TMask> successors(states);
+            for(unsigned state = 0; state < states; ++state)
+            {
+                for(typename TNFA<TChar>::TTransitions::const_iterator
+                    transition = nfa.Begin(state), end = nfa.End(state);
+                    transition != end; ++transition)
+                {
+                    SetMaskBit(successors[state], transition->Target);
+                    for(unsigned byte = 0; byte < ByteValues; ++byte)
+                    {
+                        if(transition->Contains(static_cast<TChar>(byte)))
+                        {
+                            SetMaskBit(Entered[byte], transition->Target);
+                        }
+                    }
+                }
+            }
+            // every state must be entered by the same characters from all
+            // of its predecessors
+            std::vector<TMask> entered(ByteValues);
+            for(unsigned state = 0; state < states; ++state)
+            {
+                std::fill(entered.begin(), entered.end(), TMask());
+                for(typename TNFA<TChar>::TTransitions::const_iterator
+                    transition = nfa.Begin(state), end = nfa.End(state);
+                    transition != end; ++transition)
+                {
+                    for(unsigned byte = 0; byte < ByteValues; ++byte)
+                    {
+                        if(transition->Contains(static_cast<TChar>(byte)))
+                        {
+                            SetMaskBit(entered[byte], transition->Target);
+                        }
+                    }
+                }
+                for(unsigned byte = 0; byte < ByteValues; ++byte)
+                {
+                    const TMask expected = Entered[byte] & successors[state];
+                    if(entered[byte] != expected)
+                    {
+                        throw std::logic_error(
+                            "automaton is not suitable for bit-parallel "
+                            "matcher");
+                    }
+                }
+            }
+
+            for(unsigned chunk = 0; chunk < Chunks; ++chunk)
+            {
+                TMask* table = &Follow[chunk * ByteValues];
+                // every byte value is a union of its lowest bit state and
+                // an already computed smaller value
+                for(unsigned byte = 1; byte < ByteValues; ++byte)
+                {
+                    unsigned lowest = 0;
+                    while(!(byte >> lowest & 1))
+                    {
+                        ++lowest;
+                    }
+                    const unsigned state = chunk * CHAR_BIT + lowest;
+                    table[byte] = table[byte & (byte - 1)];
+                    if(state < states)
+                    {
+                        table[byte] |= successors[state];
+                    }
+                }
+            }
+
+            for(typename TNFA<TChar>::TAcceptStates::const_iterator state =
+                nfa.AcceptStates.begin(), end = nfa.AcceptStates.end();
+                state != end; ++state)
+            {
+                SetMaskBit(AcceptStates, *state);
+            }
+            Reset();
+        }
+
+        inline void Reset()
+        {
+            Current = TMask();
+            SetMaskBit(Current, 0);
+        }
+
+        // restart adds start state after the step, which makes every
+        // position a possible match start
+        inline void Step(TChar character, bool restart = false)
+        {
+            TMask next = TMask();
+            for(unsigned chunk = 0; chunk < Chunks; ++chunk)
+            {
+                next |= Follow[chunk * ByteValues
+                    + GetMaskByte(Current, chunk)];
+            }
+            Current = next & Entered[static_cast<unsigned char>(character)];
+            if(restart)
+            {
+                SetMaskBit(Current, 0);
+            }
+        }
+
+        inline bool IsAccept() const
+        {
+            return !!(Current & AcceptStates);
+        }
+
+        inline bool IsDead() const
+        {
+            return !Current;
+        }
+
+        // returns true if the whole [begin, end) range is accepted
+        template <class TIterator>
+        bool Match(TIterator begin, TIterator end)
+        {
+            Reset();
+            for(; begin != end && !IsDead(); ++begin)
+            {
+                Step(*begin);
+            }
+            return IsAccept();
+        }
+
+        // looks for a substring accepted by automaton, on success sets
+        // matchEnd to the end of the earliest ending match
+        template <class TIterator>
+        bool Search(TIterator begin, TIterator end, TIterator& matchEnd)
+        {
+            Reset();
+            while(!IsAccept())
+            {
+                if(begin == end)
+                {
+                    return false;
+                }
+                Step(*begin, true);
+                ++begin;
+            }
+            matchEnd = begin;
+            return true;
+        }
+    };
+}
+
+#endif
+
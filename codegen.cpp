@@ -0,0 +1,103 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "alphabetgenerator.hpp"
+#include "codegenerator.hpp"
+#include "dfagenerator.hpp"
+#include "dfaminimizer.hpp"
+#include "nfagenerator.hpp"
+#include "token.hpp"
+using namespace NReinventedWheels;
+
+// prints string so it can be put into a line comment, backslash is
+// escaped too, since at the line end it would continue the comment
+void PrintEscaped(const char* pattern)
+{
+    for(; *pattern; ++pattern)
+    {
+        const unsigned char character = *pattern;
+        if(character < ' ' || character == 0x7F || character == '\\')
+        {
+            std::cout << "\\x" << "0123456789abcdef"[character >> 4]
+                << "0123456789abcdef"[character & 0xF];
+        }
+        else
+        {
+            std::cout << character;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = "Match";
+    bool anchored = false;
+    bool table = false;
+    for(int option; (option = getopt(argc, argv, "an:t")) != -1;)
+    {
+        switch(option)
+        {
+            case 'a':
+                anchored = true;
+                break;
+
+            case 'n':
+                name = optarg;
+                break;
+
+            case 't':
+                table = true;
+                break;
+
+            default:
+                argc = 0;
+                break;
+        }
+    }
+    if(optind + 1 != argc)
+    {
+        std::cerr << "usage: " << argv[0] << " [-a] [-t] [-n name] regexp\n"
+            "\tprints C++ function matching regexp to stdout\n"
+            "\t-a\tfunction checks if the whole range matches, otherwise\n"
+            "\t\tit returns the end of the earliest ending match or 0\n"
+            "\t-n\tfunction name, Match by default\n"
+            "\t-t\tprint matcher type with constant transition table for\n"
+            "\t\tMatchDFA and SearchDFA instead, -a makes it anchored\n";
+        return 2;
+    }
+
+    const char* pattern = argv[optind];
+    TNodePtr root;
+    try
+    {
+        root.Set(Parse(pattern, pattern + strlen(pattern)));
+    }
+    catch(const std::logic_error& error)
+    {
+        std::cerr << argv[0] << ": " << error.what() << std::endl;
+        return 2;
+    }
+    const TDFA<char> dfa = TDFAMinimizer<char>::Minimize(
+        TDFAGenerator<char>::CreateDFA(
+            TNFAGenerator<char>::CreateNFA(root.Get()),
+            TAlphabetGenerator<char>::CreateAlphabet(root.Get()),
+            !anchored));
+
+    std::cout << "// generated by ";
+    PrintEscaped(argv[0]);
+    std::cout << " from ";
+    PrintEscaped(pattern);
+    std::cout << "\n";
+    if(table)
+    {
+        TDFACodeGenerator<char>::GenerateTable(dfa, name, std::cout);
+    }
+    else
+    {
+        TDFACodeGenerator<char>::Generate(dfa, name, anchored, std::cout);
+    }
+    return 0;
+}
@@ -0,0 +1,274 @@
+#ifndef __CODEGENERATOR_HPP_2026_10_17__
+#define __CODEGENERATOR_HPP_2026_10_17__
+
+#include <climits>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // emits DFA as a standalone C++ function where every state is a label
+    // and every transition is a goto, so the state lives in the program
+    // counter instead of a table
+    template <class TChar>
+    class TDFACodeGenerator
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        // states reachable from the start state, search function stops in
+        // accept states, so their transitions are not followed
+        static std::vector<bool> GetReachable(const TDFA<TChar>& dfa,
+            bool anchored)
+        {
+            std::vector<bool> result(dfa.StatesCount);
+            std::vector<unsigned> queue(1, TDFA<TChar>::StartState);
+            result[TDFA<TChar>::StartState] = true;
+            while(!queue.empty())
+            {
+                const unsigned state = queue.back();
+                queue.pop_back();
+                if(state == TDFA<TChar>::DeadState
+                    || (!anchored && dfa.IsAccept(state)))
+                {
+                    continue;
+                }
+                for(unsigned symbol = 0; symbol < dfa.Alphabet.ClassesCount;
+                    ++symbol)
+                {
+                    const unsigned target = dfa.Transitions[
+                        state * dfa.Alphabet.ClassesCount + symbol];
+                    if(!result[target])
+                    {
+                        result[target] = true;
+                        queue.push_back(target);
+                    }
+                }
+            }
+            return result;
+        }
+
+        static void GenerateSwitch(const TDFA<TChar>& dfa, unsigned state,
+            std::ostream& output)
+        {
+            // bytes leading to every target, the largest group becomes the
+            // default branch
+            std::map<unsigned, std::vector<unsigned> > targets;
+            for(unsigned byte = 0; byte < TAlphabet::Size; ++byte)
+            {
+                targets[dfa.Next(state, static_cast<TChar>(byte))]
+                    .push_back(byte);
+            }
+            std::map<unsigned, std::vector<unsigned> >::const_iterator
+                fallback = targets.begin();
+            for(std::map<unsigned, std::vector<unsigned> >::const_iterator
+                target = targets.begin(), end = targets.end();
+                target != end; ++target)
+            {
+                if(target->second.size() > fallback->second.size())
+                {
+                    fallback = target;
+                }
+            }
+
+            output << "    switch(static_cast<unsigned char>(*pos++))\n"
+                "    {\n";
+            for(std::map<unsigned, std::vector<unsigned> >::const_iterator
+                target = targets.begin(), end = targets.end();
+                target != end; ++target)
+            {
+                if(target == fallback)
+                {
+                    continue;
+                }
+                for(std::vector<unsigned>::const_iterator byte =
+                    target->second.begin(), last = target->second.end();
+                    byte != last; ++byte)
+                {
+                    output << "        case " << *byte << ":\n";
+                }
+                output << "            goto state" << target->first
+                    << ";\n";
+            }
+            output << "        default:\n"
+                "            goto state" << fallback->first << ";\n"
+                "    }\n";
+        }
+
+        // prints values as the body of an array initializer
+        template <class TIterator>
+        static void GenerateArray(TIterator begin, TIterator end,
+            std::ostream& output)
+        {
+            unsigned column = 0;
+            for(; begin != end; ++begin)
+            {
+                output << (column ? " " : "            ") << *begin << ",";
+                if(++column == 12)
+                {
+                    output << "\n";
+                    column = 0;
+                }
+            }
+            if(column)
+            {
+                output << "\n";
+            }
+        }
+
+        // the narrowest unsigned type able to hold any state
+        static const char* GetStateType(unsigned statesCount)
+        {
+            if(statesCount <= 1u << CHAR_BIT)
+            {
+                return "unsigned char";
+            }
+            if(statesCount <= 1u << 16)
+            {
+                return "unsigned short";
+            }
+            return "unsigned";
+        }
+
+    public:
+        // anchored function returns true if the whole [begin, end) range is
+        // accepted, search function expects unanchored dfa and returns the
+        // end of the earliest ending match or 0
+        static void Generate(const TDFA<TChar>& dfa, const std::string& name,
+            bool anchored, std::ostream& output)
+        {
+            const std::vector<bool> reachable = GetReachable(dfa, anchored);
+            if(anchored)
+            {
+                output << "inline bool " << name
+                    << "(const char* begin, const char* end)\n";
+            }
+            else
+            {
+                output << "inline const char* " << name
+                    << "(const char* begin, const char* end)\n";
+            }
+            output << "{\n"
+                "    const char* pos = begin;\n";
+            // search function of a pattern matching empty string returns
+            // before reading anything
+            bool readsEnd = anchored;
+            for(unsigned state = 0; state < dfa.StatesCount; ++state)
+            {
+                readsEnd |= reachable[state]
+                    && state != TDFA<TChar>::DeadState
+                    && !dfa.IsAccept(state);
+            }
+            if(!readsEnd)
+            {
+                output << "    (void)end;\n";
+            }
+            output << "    goto state" << static_cast<unsigned>(
+                TDFA<TChar>::StartState) << ";\n";
+
+            const char* const success = anchored ? "true" : "pos";
+            const char* const failure = anchored ? "false" : "0";
+            for(unsigned state = 0; state < dfa.StatesCount; ++state)
+            {
+                if(!reachable[state])
+                {
+                    continue;
+                }
+                output << "state" << state << ":\n";
+                if(state == TDFA<TChar>::DeadState)
+                {
+                    output << "    return " << failure << ";\n";
+                    continue;
+                }
+                if(anchored)
+                {
+                    output << "    if(pos == end)\n"
+                        "    {\n"
+                        "        return " << (dfa.IsAccept(state)
+                            ? success : failure) << ";\n"
+                        "    }\n";
+                }
+                else if(dfa.IsAccept(state))
+                {
+                    output << "    return " << success << ";\n";
+                    continue;
+                }
+                else
+                {
+                    output << "    if(pos == end)\n"
+                        "    {\n"
+                        "        return " << failure << ";\n"
+                        "    }\n";
+                }
+                GenerateSwitch(dfa, state, output);
+            }
+            output << "}\n";
+        }
+
+        // emits matcher type usable with MatchDFA and SearchDFA, its tables
+        // are constant initialized function local arrays, so they are
+        // placed in read-only data, shared by all translation units and
+        // need neither heap nor initialization at startup
+        static void GenerateTable(const TDFA<TChar>& dfa,
+            const std::string& name, std::ostream& output)
+        {
+            const char* const stateType = GetStateType(dfa.StatesCount);
+            std::vector<unsigned> classes(TAlphabet::Size);
+            for(unsigned byte = 0; byte < TAlphabet::Size; ++byte)
+            {
+                classes[byte] = dfa.Alphabet[byte];
+            }
+            std::vector<unsigned> accept(dfa.StatesCount);
+            for(unsigned state = 0; state < dfa.StatesCount; ++state)
+            {
+                accept[state] = dfa.IsAccept(state);
+            }
+
+            output << "struct " << name << "\n"
+                "{\n"
+                "    enum\n"
+                "    {\n"
+                "        DeadState = " << static_cast<unsigned>(
+                    TDFA<TChar>::DeadState) << ",\n"
+                "        StartState = " << static_cast<unsigned>(
+                    TDFA<TChar>::StartState) << ",\n"
+                "        StatesCount = " << dfa.StatesCount << ",\n"
+                "        ClassesCount = " << dfa.Alphabet.ClassesCount
+                << "\n"
+                "    };\n"
+                "\n"
+                "    inline unsigned Next(unsigned state, char character) "
+                "const\n"
+                "    {\n"
+                "        static const unsigned char classes[256] =\n"
+                "        {\n";
+            GenerateArray(classes.begin(), classes.end(), output);
+            output << "        };\n"
+                "        static const " << stateType
+                << " transitions[StatesCount * ClassesCount] =\n"
+                "        {\n";
+            GenerateArray(dfa.Transitions.begin(), dfa.Transitions.end(),
+                output);
+            output << "        };\n"
+                "        return transitions[state * ClassesCount\n"
+                "            + classes[static_cast<unsigned char>("
+                "character)]];\n"
+                "    }\n"
+                "\n"
+                "    inline bool IsAccept(unsigned state) const\n"
+                "    {\n"
+                "        static const bool accept[StatesCount] =\n"
+                "        {\n";
+            GenerateArray(accept.begin(), accept.end(), output);
+            output << "        };\n"
+                "        return accept[state];\n"
+                "    }\n"
+                "};\n";
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef __DFAGENERATOR_HPP_2026_10_17__
+#define __DFAGENERATOR_HPP_2026_10_17__
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // subset construction, each DFA state is the set of NFA states reachable
+    // by the same input
+    template <class TChar>
+    class TDFAGenerator
+    {
+        // dense transition table is indexed by byte values
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        // ordered, without duplicates
+        typedef std::vector<unsigned> TStateSet;
+        typedef std::map<TStateSet, unsigned> TStateSets;
+        typedef std::vector<typename TStateSets::const_iterator> TQueue;
+
+        static const unsigned NotAccept = static_cast<unsigned>(-1);
+
+        // returns DFA state for the set, enqueues it if the set is new,
+        // transitions of the new state lead to fallback
+        static unsigned AddStateSet(TDFA<TChar>& dfa, TStateSets& sets,
+            TQueue& queue, const TStateSet& set, unsigned fallback)
+        {
+            std::pair<typename TStateSets::iterator, bool> result =
+                sets.insert(std::make_pair(set, dfa.StatesCount));
+            if(result.second)
+            {
+                queue.push_back(result.first);
+                ++dfa.StatesCount;
+                dfa.Transitions.resize(
+                    dfa.StatesCount * dfa.Alphabet.ClassesCount, fallback);
+            }
+            return result.first->second;
+        }
+
+        // byte classes entered by transitions, transition i classes are
+        // [offsets[ranges[i]], offsets[ranges[i] + 1]) elements of classes,
+        // transitions with equal ranges share them
+        static void GetTransitionClasses(const TNFA<TChar>& nfa,
+            const TAlphabet& alphabet, std::vector<unsigned>& ranges,
+            std::vector<unsigned>& offsets,
+            std::vector<unsigned char>& classes)
+        {
+            std::map<std::pair<TChar, TChar>, unsigned> ids;
+            std::vector<bool> seen(alphabet.ClassesCount);
+            ranges.resize(nfa.Transitions.size());
+            offsets.assign(1, 0);
+            for(unsigned i = 0; i < nfa.Transitions.size(); ++i)
+            {
+                const typename TNFA<TChar>::TTransition& transition =
+                    nfa.Transitions[i];
+                const std::pair<typename std::map<std::pair<TChar, TChar>,
+                    unsigned>::iterator, bool> id = ids.insert(
+                        std::make_pair(std::make_pair(transition.First,
+                            transition.Last), ids.size()));
+                ranges[i] = id.first->second;
+                if(!id.second)
+                {
+                    continue;
+                }
+                const unsigned begin = classes.size();
+                for(unsigned byte = 0; byte < TAlphabet::Size; ++byte)
+                {
+                    const unsigned char symbol = alphabet[byte];
+                    if(!seen[symbol]
+                        && transition.Contains(static_cast<TChar>(byte)))
+                    {
+                        seen[symbol] = true;
+                        classes.push_back(symbol);
+                    }
+                }
+                for(unsigned j = begin; j < classes.size(); ++j)
+                {
+                    seen[classes[j]] = false;
+                }
+                offsets.push_back(classes.size());
+            }
+        }
+
+    public:
+        // every accept state keeps the union of patterns accepted by its
+        // NFA states
+        // alphabet must not merge characters distinguished by the nfa,
+        // unanchored automaton restarts from the NFA start state on every
+        // character, so it accepts after every prefix ending with a match
+        static TDFA<TChar> CreateDFA(const TNFA<TChar>& nfa,
+            const TAlphabet& alphabet, bool unanchored = false)
+        {
+            // index in nfa.AcceptStates for every accept state
+            std::vector<unsigned> acceptIndex(nfa.StatesCount(), NotAccept);
+            for(unsigned i = 0; i < nfa.AcceptStates.size(); ++i)
+            {
+                acceptIndex[nfa.AcceptStates[i]] = i;
+            }
+
+            TDFA<TChar> result;
+            result.Alphabet = alphabet;
+            const unsigned classes = alphabet.ClassesCount;
+            // dead state row
+            result.StatesCount = 1;
+            result.Transitions.resize(classes, TDFA<TChar>::DeadState);
+            result.PatternOffsets.assign(2, 0);
+
+            // the NFA start state has no incoming transitions, so only the
+            // unanchored start state set consists of it alone
+            const unsigned fallback = unanchored
+                ? static_cast<unsigned>(TDFA<TChar>::StartState)
+                : static_cast<unsigned>(TDFA<TChar>::DeadState);
+            TStateSets sets;
+            TQueue queue;
+            AddStateSet(result, sets, queue, TStateSet(1, 0), fallback);
+
+            std::vector<unsigned> rangeIds;
+            std::vector<unsigned> rangeOffsets;
+            std::vector<unsigned char> rangeClasses;
+            GetTransitionClasses(nfa, alphabet, rangeIds, rangeOffsets,
+                rangeClasses);
+
+            std::vector<TStateSet> targets(classes);
+            std::vector<unsigned char> touched;
+            std::vector<unsigned> acceptStates;
+            // queue index plus one is the DFA state number
+            for(typename TQueue::size_type current = 0;
+                current < queue.size(); ++current)
+            {
+                const TStateSet& set = queue[current]->first;
+                const unsigned patterns = result.AcceptPatterns.size();
+                for(TStateSet::const_iterator state = set.begin(),
+                    end = set.end(); state != end; ++state)
+                {
+                    const unsigned index = acceptIndex[*state];
+                    if(index != NotAccept)
+                    {
+                        result.AcceptPatterns.insert(
+                            result.AcceptPatterns.end(),
+                            nfa.AcceptPatterns.begin()
+                                + nfa.PatternOffsets[index],
+                            nfa.AcceptPatterns.begin()
+                                + nfa.PatternOffsets[index + 1]);
+                    }
+                    for(unsigned transition = nfa.Offsets[*state],
+                        end = nfa.Offsets[*state + 1]; transition != end;
+                        ++transition)
+                    {
+                        const unsigned range = rangeIds[transition];
+                        const unsigned target =
+                            nfa.Transitions[transition].Target;
+                        for(unsigned i = rangeOffsets[range];
+                            i < rangeOffsets[range + 1]; ++i)
+                        {
+                            const unsigned char symbol = rangeClasses[i];
+                            if(targets[symbol].empty())
+                            {
+                                touched.push_back(symbol);
+                            }
+                            targets[symbol].push_back(target);
+                        }
+                    }
+                }
+                if(result.AcceptPatterns.size() != patterns)
+                {
+                    acceptStates.push_back(current + 1);
+                    std::sort(result.AcceptPatterns.begin() + patterns,
+                        result.AcceptPatterns.end());
+                    result.AcceptPatterns.erase(std::unique(
+                        result.AcceptPatterns.begin() + patterns,
+                        result.AcceptPatterns.end()),
+                        result.AcceptPatterns.end());
+                }
+                result.PatternOffsets.push_back(result.AcceptPatterns.size());
+
+                for(std::vector<unsigned char>::const_iterator symbol =
+                    touched.begin(), end = touched.end(); symbol != end;
+                    ++symbol)
+                {
+                    TStateSet& target = targets[*symbol];
+                    if(unanchored)
+                    {
+                        target.push_back(0);
+                    }
+                    std::sort(target.begin(), target.end());
+                    target.erase(std::unique(target.begin(), target.end()),
+                        target.end());
+                    const unsigned state =
+                        AddStateSet(result, sets, queue, target, fallback);
+                    result.Transitions[(current + 1) * classes + *symbol] =
+                        state;
+                    target.clear();
+                }
+                touched.clear();
+            }
+
+            result.AcceptStates.resize((result.StatesCount
+                + sizeof(unsigned) * CHAR_BIT - 1)
+                / (sizeof(unsigned) * CHAR_BIT));
+            for(std::vector<unsigned>::const_iterator state =
+                acceptStates.begin(), end = acceptStates.end(); state != end;
+                ++state)
+            {
+                result.SetAccept(*state);
+            }
+            return result;
+        }
+
+        // automaton for leftmost-longest search: it starts a new match on
+        // every character like unanchored one, but keeps NFA states of
+        // matches started earlier apart from later ones and stops starting
+        // new matches once one of them is found, so the last accept state
+        // met before the dead state ends the leftmost-longest match
+        // accept states keep patterns of the group which has accepted
+        // states are TStateGroups keys, there can be far more of them than
+        // of unanchored automaton states, all are built here, while
+        // TLazyDFA builds them on demand in a bounded cache
+        static TDFA<TChar> CreateLeftmostLongestDFA(const TNFA<TChar>& nfa,
+            const TAlphabet& alphabet)
+        {
+            std::vector<unsigned> acceptIndex(nfa.StatesCount(), NotAccept);
+            std::vector<bool> accept(nfa.StatesCount());
+            for(unsigned i = 0; i < nfa.AcceptStates.size(); ++i)
+            {
+                acceptIndex[nfa.AcceptStates[i]] = i;
+                accept[nfa.AcceptStates[i]] = true;
+            }
+
+            TDFA<TChar> result;
+            result.Alphabet = alphabet;
+            const unsigned classes = alphabet.ClassesCount;
+            result.StatesCount = 1;
+            result.Transitions.resize(classes, TDFA<TChar>::DeadState);
+            result.PatternOffsets.assign(2, 0);
+
+            std::vector<bool> seen(nfa.StatesCount());
+            TStateSet key;
+            TStateSet groups;
+            TStateGroups::MakeKey(groups, true, accept, seen, key);
+            TStateSets sets;
+            TQueue queue;
+            AddStateSet(result, sets, queue, key, TDFA<TChar>::DeadState);
+
+            std::vector<unsigned> rangeIds;
+            std::vector<unsigned> rangeOffsets;
+            std::vector<unsigned char> rangeClasses;
+            GetTransitionClasses(nfa, alphabet, rangeIds, rangeOffsets,
+                rangeClasses);
+
+            // target groups by every symbol, separated like in the key
+            std::vector<TStateSet> targets(classes);
+            std::vector<unsigned char> touched;
+            std::vector<unsigned> acceptStates;
+            for(typename TQueue::size_type current = 0;
+                current < queue.size(); ++current)
+            {
+                const TStateSet& set = queue[current]->first;
+                const unsigned patterns = result.AcceptPatterns.size();
+                for(TStateSet::const_iterator last =
+                    TStateGroups::LastGroup(set);
+                    *last != TStateGroups::Separator; ++last)
+                {
+                    const unsigned index = acceptIndex[*last];
+                    if(index != NotAccept)
+                    {
+                        result.AcceptPatterns.insert(
+                            result.AcceptPatterns.end(),
+                            nfa.AcceptPatterns.begin()
+                                + nfa.PatternOffsets[index],
+                            nfa.AcceptPatterns.begin()
+                                + nfa.PatternOffsets[index + 1]);
+                    }
+                }
+                if(result.AcceptPatterns.size() != patterns)
+                {
+                    acceptStates.push_back(current + 1);
+                    std::sort(result.AcceptPatterns.begin() + patterns,
+                        result.AcceptPatterns.end());
+                    result.AcceptPatterns.erase(std::unique(
+                        result.AcceptPatterns.begin() + patterns,
+                        result.AcceptPatterns.end()),
+                        result.AcceptPatterns.end());
+                }
+                result.PatternOffsets.push_back(result.AcceptPatterns.size());
+
+                for(TStateSet::const_iterator state = set.begin() + 1,
+                    end = set.end(); state != end; ++state)
+                {
+                    if(*state == TStateGroups::Separator)
+                    {
+                        for(std::vector<unsigned char>::const_iterator
+                            symbol = touched.begin(), end = touched.end();
+                            symbol != end; ++symbol)
+                        {
+                            if(targets[*symbol].back()
+                                != TStateGroups::Separator)
+                            {
+                                targets[*symbol].push_back(
+                                    TStateGroups::Separator);
+                            }
+                        }
+                        continue;
+                    }
+                    for(unsigned transition = nfa.Offsets[*state],
+                        end = nfa.Offsets[*state + 1]; transition != end;
+                        ++transition)
+                    {
+                        const unsigned range = rangeIds[transition];
+                        const unsigned target =
+                            nfa.Transitions[transition].Target;
+                        for(unsigned i = rangeOffsets[range];
+                            i < rangeOffsets[range + 1]; ++i)
+                        {
+                            const unsigned char symbol = rangeClasses[i];
+                            if(targets[symbol].empty())
+                            {
+                                touched.push_back(symbol);
+                            }
+                            targets[symbol].push_back(target);
+                        }
+                    }
+                }
+                touched.clear();
+
+                // symbols without targets still lead to a new start
+                for(unsigned symbol = 0; symbol < classes; ++symbol)
+                {
+                    TStateGroups::MakeKey(targets[symbol], set.front(),
+                        accept, seen, key);
+                    targets[symbol].clear();
+                    if(key.size() > 1)
+                    {
+                        const unsigned state = AddStateSet(result, sets,
+                            queue, key, TDFA<TChar>::DeadState);
+                        result.Transitions[(current + 1) * classes + symbol]
+                            = state;
+                    }
+                }
+            }
+
+            result.AcceptStates.resize((result.StatesCount
+                + sizeof(unsigned) * CHAR_BIT - 1)
+                / (sizeof(unsigned) * CHAR_BIT));
+            for(std::vector<unsigned>::const_iterator state =
+                acceptStates.begin(), end = acceptStates.end(); state != end;
+                ++state)
+            {
+                result.SetAccept(*state);
+            }
+            return result;
+        }
+    };
+
+    template <class TChar>
+    const unsigned TDFAGenerator<TChar>::NotAccept;
+}
+
+#endif
+
@@ -0,0 +1,124 @@
+#ifndef __DFAMATCHER_HPP_2026_10_17__
+#define __DFAMATCHER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // returns true if the whole [begin, end) range is accepted, automaton
+    // can be either TDFA or TLazyDFA
+    template <class TAutomaton, class TIterator>
+    inline bool MatchDFA(TAutomaton& dfa, TIterator begin, TIterator end)
+    {
+        unsigned state = TAutomaton::StartState;
+        for(; begin != end && state != TAutomaton::DeadState; ++begin)
+        {
+            state = dfa.Next(state, *begin);
+        }
+        return dfa.IsAccept(state);
+    }
+
+    // dfa must be created unanchored, on success sets matchEnd to the end of
+    // the earliest ending match
+    template <class TAutomaton, class TIterator>
+    inline bool SearchDFA(TAutomaton& dfa, TIterator begin, TIterator end,
+        TIterator& matchEnd)
+    {
+        unsigned state = TAutomaton::StartState;
+        while(!dfa.IsAccept(state))
+        {
+            if(begin == end || state == TAutomaton::DeadState)
+            {
+                return false;
+            }
+            state = dfa.Next(state, *begin);
+            ++begin;
+        }
+        matchEnd = begin;
+        return true;
+    }
+
+    // appends ids of patterns matching a substring of [begin, end) to
+    // patterns, ordered and without duplicates, automaton can be either
+    // TDFA created unanchored or TAhoCorasick
+    template <class TAutomaton, class TIterator>
+    void SearchPatternsDFA(const TAutomaton& dfa, TIterator begin,
+        TIterator end, std::vector<unsigned>& patterns)
+    {
+        // accept states met, the same state is usually met many times in a
+        // row, so only those repetitions are skipped here
+        std::vector<unsigned> states;
+        unsigned state = TAutomaton::StartState;
+        for(;; ++begin)
+        {
+            if(dfa.IsAccept(state) && (states.empty()
+                || states.back() != state))
+            {
+                states.push_back(state);
+            }
+            if(begin == end || state == TAutomaton::DeadState)
+            {
+                break;
+            }
+            state = dfa.Next(state, *begin);
+        }
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()),
+            states.end());
+        const std::vector<unsigned>::size_type size = patterns.size();
+        for(std::vector<unsigned>::const_iterator accept = states.begin(),
+            last = states.end(); accept != last; ++accept)
+        {
+            patterns.insert(patterns.end(), dfa.PatternsBegin(*accept),
+                dfa.PatternsEnd(*accept));
+        }
+        std::sort(patterns.begin() + size, patterns.end());
+        patterns.erase(std::unique(patterns.begin() + size, patterns.end()),
+            patterns.end());
+    }
+
+    // keeps current DFA state, provides the same stepping interface as
+    // TNFAMatcher and TBitParallelMatcher
+    // restarting on every character is up to DFA creation, so restart flag
+    // is ignored
+    template <class TAutomaton>
+    class TDFAStepper
+    {
+        TAutomaton& DFA;
+        unsigned State;
+
+    public:
+        inline TDFAStepper(TAutomaton& dfa)
+            : DFA(dfa)
+            , State(TAutomaton::StartState)
+        {
+        }
+
+        inline void Reset()
+        {
+            State = TAutomaton::StartState;
+        }
+
+        template <class TChar>
+        inline void Step(TChar character, bool = false)
+        {
+            State = DFA.Next(State, character);
+        }
+
+        inline bool IsAccept() const
+        {
+            return DFA.IsAccept(State);
+        }
+
+        inline bool IsDead() const
+        {
+            return State == TAutomaton::DeadState;
+        }
+    };
+}
+
+#endif
+
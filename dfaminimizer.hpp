@@ -0,0 +1,329 @@
+#ifndef __DFAMINIMIZER_HPP_2026_10_17__
+#define __DFAMINIMIZER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    struct TMinimizationStats
+    {
+        unsigned StatesBefore;
+        unsigned StatesAfter;
+    };
+
+    // Hopcroft's partition refinement, O(n log n) per alphabet symbol,
+    // states accepting different patterns are kept apart
+    template <class TChar>
+    class TDFAMinimizer
+    {
+        // states are kept grouped by block in Elements, each block occupies
+        // [First, End) and its marked states are [First, First + Marked)
+        struct TBlock
+        {
+            unsigned First;
+            unsigned End;
+            unsigned Marked;
+        };
+
+        class TPartition
+        {
+        public:
+            std::vector<unsigned> Elements;
+            std::vector<unsigned> Locations;
+            std::vector<unsigned> BlockOf;
+            std::vector<TBlock> Blocks;
+
+            inline TPartition(unsigned size)
+                : Elements(size)
+                , Locations(size)
+                , BlockOf(size)
+            {
+            }
+
+            inline void AddBlock(unsigned first, unsigned end)
+            {
+                TBlock block = {first, end, 0};
+                for(unsigned location = first; location != end; ++location)
+                {
+                    BlockOf[Elements[location]] = Blocks.size();
+                }
+                Blocks.push_back(block);
+            }
+
+            // returns true if the block had no marked states yet
+            inline bool Mark(unsigned state)
+            {
+                TBlock& block = Blocks[BlockOf[state]];
+                const unsigned location = Locations[state];
+                const unsigned target = block.First + block.Marked;
+                if(location < target)
+                {
+                    // already marked
+                    return false;
+                }
+                std::swap(Elements[location], Elements[target]);
+                Locations[Elements[location]] = location;
+                Locations[state] = target;
+                return !block.Marked++;
+            }
+        };
+
+        // orders states by acceptance and accepted patterns
+        class TPatternsLess
+        {
+            const TDFA<TChar>& DFA;
+
+        public:
+            inline TPatternsLess(const TDFA<TChar>& dfa)
+                : DFA(dfa)
+            {
+            }
+
+            inline bool operator () (unsigned first, unsigned second) const
+            {
+                if(DFA.IsAccept(first) != DFA.IsAccept(second))
+                {
+                    return DFA.IsAccept(second);
+                }
+                return std::lexicographical_compare(
+                    DFA.PatternsBegin(first), DFA.PatternsEnd(first),
+                    DFA.PatternsBegin(second), DFA.PatternsEnd(second));
+            }
+        };
+
+        static void BuildReverse(const TDFA<TChar>& dfa,
+            std::vector<unsigned>& offsets, std::vector<unsigned>& sources)
+        {
+            const unsigned count = dfa.StatesCount;
+            const unsigned symbols = dfa.Alphabet.ClassesCount;
+            // reverse transitions on symbol a into state t are
+            // [offsets[a * count + t], offsets[a * count + t + 1])
+            offsets.assign(symbols * count + 1, 0);
+            for(unsigned state = 0; state < count; ++state)
+            {
+                for(unsigned symbol = 0; symbol < symbols; ++symbol)
+                {
+                    ++offsets[symbol * count + dfa.Transitions[
+                        state * symbols + symbol] + 1];
+                }
+            }
+            for(std::vector<unsigned>::size_type i = 1; i < offsets.size();
+                ++i)
+            {
+                offsets[i] += offsets[i - 1];
+            }
+            sources.resize(offsets.back());
+            std::vector<unsigned> positions(offsets.begin(),
+                offsets.end() - 1);
+            for(unsigned state = 0; state < count; ++state)
+            {
+                for(unsigned symbol = 0; symbol < symbols; ++symbol)
+                {
+                    sources[positions[symbol * count + dfa.Transitions[
+                        state * symbols + symbol]]++] = state;
+                }
+            }
+        }
+
+        static void Refine(const TDFA<TChar>& dfa, TPartition& partition)
+        {
+            std::vector<unsigned> offsets;
+            std::vector<unsigned> sources;
+            BuildReverse(dfa, offsets, sources);
+
+            const unsigned count = dfa.StatesCount;
+            const unsigned symbols = dfa.Alphabet.ClassesCount;
+            // (block, symbol) pairs waiting to be used as splitters, there
+            // are never more blocks than states
+            std::vector<std::pair<unsigned, unsigned> > pending;
+            std::vector<bool> isPending(symbols * count);
+            // every initial block but the largest one is a splitter
+            unsigned largest = 0;
+            for(unsigned block = 1; block < partition.Blocks.size(); ++block)
+            {
+                if(partition.Blocks[block].End - partition.Blocks[block].First
+                    > partition.Blocks[largest].End
+                    - partition.Blocks[largest].First)
+                {
+                    largest = block;
+                }
+            }
+            for(unsigned block = 0; block < partition.Blocks.size(); ++block)
+            {
+                if(block == largest)
+                {
+                    continue;
+                }
+                for(unsigned symbol = 0; symbol < symbols; ++symbol)
+                {
+                    pending.push_back(std::make_pair(block, symbol));
+                    isPending[block * symbols + symbol] = true;
+                }
+            }
+
+            std::vector<unsigned> splitter;
+            std::vector<unsigned> touched;
+            while(!pending.empty())
+            {
+                const unsigned block = pending.back().first;
+                const unsigned symbol = pending.back().second;
+                pending.pop_back();
+                isPending[block * symbols + symbol] = false;
+
+                // block contents may change while marking, take a snapshot
+                splitter.assign(
+                    partition.Elements.begin() + partition.Blocks[block].First,
+                    partition.Elements.begin() + partition.Blocks[block].End);
+                for(std::vector<unsigned>::const_iterator state =
+                    splitter.begin(), end = splitter.end(); state != end;
+                    ++state)
+                {
+                    for(unsigned i = offsets[symbol * count + *state],
+                        last = offsets[symbol * count + *state + 1];
+                        i != last; ++i)
+                    {
+                        if(partition.Mark(sources[i]))
+                        {
+                            touched.push_back(partition.BlockOf[sources[i]]);
+                        }
+                    }
+                }
+
+                for(std::vector<unsigned>::const_iterator current =
+                    touched.begin(), end = touched.end(); current != end;
+                    ++current)
+                {
+                    TBlock& split = partition.Blocks[*current];
+                    const unsigned middle = split.First + split.Marked;
+                    split.Marked = 0;
+                    if(middle == split.End)
+                    {
+                        continue;
+                    }
+                    // marked part becomes the new block
+                    const unsigned first = split.First;
+                    split.First = middle;
+                    const unsigned created = partition.Blocks.size();
+                    partition.AddBlock(first, middle);
+                    const TBlock& rest = partition.Blocks[*current];
+                    const bool createdSmaller =
+                        middle - first < rest.End - rest.First;
+                    for(unsigned a = 0; a < symbols; ++a)
+                    {
+                        unsigned add = created;
+                        if(!isPending[*current * symbols + a]
+                            && !createdSmaller)
+                        {
+                            add = *current;
+                        }
+                        if(!isPending[add * symbols + a])
+                        {
+                            pending.push_back(std::make_pair(add, a));
+                            isPending[add * symbols + a] = true;
+                        }
+                    }
+                }
+                touched.clear();
+            }
+        }
+
+    public:
+        static TDFA<TChar> Minimize(const TDFA<TChar>& dfa,
+            TMinimizationStats* stats = 0)
+        {
+            const unsigned count = dfa.StatesCount;
+            const unsigned symbols = dfa.Alphabet.ClassesCount;
+            TPartition partition(count);
+            // states accepting different patterns are never equivalent, so
+            // initial blocks are formed by accepted pattern sets
+            const TPatternsLess less(dfa);
+            for(unsigned state = 0; state < count; ++state)
+            {
+                partition.Elements[state] = state;
+            }
+            std::sort(partition.Elements.begin(), partition.Elements.end(),
+                less);
+            for(unsigned location = 0; location < count; ++location)
+            {
+                partition.Locations[partition.Elements[location]] = location;
+            }
+            for(unsigned first = 0, end; first < count; first = end)
+            {
+                for(end = first + 1; end < count && !less(
+                    partition.Elements[first], partition.Elements[end]);
+                    ++end)
+                {
+                }
+                partition.AddBlock(first, end);
+            }
+
+            Refine(dfa, partition);
+
+            // dead state block keeps number 0 and start state block number
+            // 1, even if the language is empty and they are equivalent
+            const unsigned unassigned = static_cast<unsigned>(-1);
+            std::vector<unsigned> numbers(partition.Blocks.size(),
+                unassigned);
+            std::vector<unsigned> representatives;
+            numbers[partition.BlockOf[TDFA<TChar>::DeadState]] =
+                TDFA<TChar>::DeadState;
+            representatives.push_back(TDFA<TChar>::DeadState);
+            if(numbers[partition.BlockOf[TDFA<TChar>::StartState]]
+                == unassigned)
+            {
+                numbers[partition.BlockOf[TDFA<TChar>::StartState]] =
+                    TDFA<TChar>::StartState;
+            }
+            representatives.push_back(TDFA<TChar>::StartState);
+            for(unsigned state = 0; state < count; ++state)
+            {
+                unsigned& number = numbers[partition.BlockOf[state]];
+                if(number == unassigned)
+                {
+                    number = representatives.size();
+                    representatives.push_back(state);
+                }
+            }
+
+            TDFA<TChar> result;
+            result.Alphabet = dfa.Alphabet;
+            result.StatesCount = representatives.size();
+            result.Transitions.resize(result.StatesCount * symbols);
+            result.AcceptStates.resize((result.StatesCount
+                + sizeof(unsigned) * CHAR_BIT - 1)
+                / (sizeof(unsigned) * CHAR_BIT));
+            result.PatternOffsets.push_back(0);
+            for(unsigned state = 0; state < result.StatesCount; ++state)
+            {
+                const unsigned representative = representatives[state];
+                for(unsigned symbol = 0; symbol < symbols; ++symbol)
+                {
+                    result.Transitions[state * symbols + symbol] =
+                        numbers[partition.BlockOf[dfa.Transitions[
+                        representative * symbols + symbol]]];
+                }
+                if(dfa.IsAccept(representative))
+                {
+                    result.SetAccept(state);
+                }
+                result.AcceptPatterns.insert(result.AcceptPatterns.end(),
+                    dfa.PatternsBegin(representative),
+                    dfa.PatternsEnd(representative));
+                result.PatternOffsets.push_back(result.AcceptPatterns.size());
+            }
+
+            if(stats)
+            {
+                stats->StatesBefore = count;
+                stats->StatesAfter = result.StatesCount;
+            }
+            return result;
+        }
+    };
+}
+
+#endif
+
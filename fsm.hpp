@@ -1,40 +1,376 @@
 #ifndef __FSM_HPP_2011_10_11__
 #define __FSM_HPP_2011_10_11__
 
-#include <functional>
-#include <map>
-#include <memory>
+#include <algorithm>
+#include <climits>
 #include <utility>
 #include <vector>
 
 namespace NReinventedWheels
 {
-    template <class TChar,
-        template <class TKey,
-            class TValue,
-            class = std::less<TKey>,
-            class = std::allocator<std::pair<const TKey, TValue> > >
-        class TTransitionTable>
-    struct TFA
+    // splits bytes into classes which are never distinguished by automaton
+    struct TAlphabet
     {
-        typedef TTransitionTable<TChar, unsigned> TState;
-        typedef typename std::vector<TState> TStates;
-        // not empty
-        TStates States;
+        enum
+        {
+            Size = UCHAR_MAX + 1
+        };
+
+        unsigned char Classes[Size];
+        unsigned ClassesCount;
+
+        inline TAlphabet()
+            : ClassesCount(1)
+        {
+            std::fill(Classes, Classes + Size, 0);
+        }
+
+        // splits classes so bytes from [first, last] will not share class
+        // with any byte outside of this range
+        template <class TChar>
+        void AddRange(TChar first, TChar last)
+        {
+            unsigned inside[Size] = {};
+            unsigned total[Size] = {};
+            for(unsigned byte = 0; byte < Size; ++byte)
+            {
+                const TChar character = static_cast<TChar>(byte);
+                inside[Classes[byte]] +=
+                    !(character < first) && !(last < character);
+                ++total[Classes[byte]];
+            }
+            unsigned char split[Size];
+            for(unsigned current = 0, count = ClassesCount; current < count;
+                ++current)
+            {
+                split[current] = current;
+                if(inside[current] && inside[current] != total[current])
+                {
+                    split[current] = ClassesCount++;
+                }
+            }
+            for(unsigned byte = 0; byte < Size; ++byte)
+            {
+                const TChar character = static_cast<TChar>(byte);
+                if(!(character < first) && !(last < character))
+                {
+                    Classes[byte] = split[Classes[byte]];
+                }
+            }
+        }
+
+        inline unsigned operator [] (unsigned char byte) const
+        {
+            return Classes[byte];
+        }
+    };
+
+    // dense automaton over byte classes, suitable for O(1) per character
+    // matching, matching state is kept by callers, so once built automaton
+    // can be shared between threads through const reference
+    template <class TChar>
+    struct TDFA
+    {
+        enum
+        {
+            // all transitions of the dead state lead to itself
+            DeadState = 0,
+            StartState = 1
+        };
+
+        TAlphabet Alphabet;
+
+        // includes dead state
+        unsigned StatesCount;
+
+        typedef std::vector<unsigned> TTransitions;
+        // StatesCount rows of Alphabet.ClassesCount target states
+        TTransitions Transitions;
+
+        typedef std::vector<unsigned> TAcceptStates;
+        // bitmap, one bit per state
+        TAcceptStates AcceptStates;
+
+        typedef std::vector<unsigned> TOffsets;
+        typedef std::vector<unsigned> TPatterns;
+        // patterns accepted in state i are [PatternOffsets[i],
+        // PatternOffsets[i + 1]) elements of AcceptPatterns, ordered
+        TOffsets PatternOffsets;
+        TPatterns AcceptPatterns;
+
+        inline TDFA()
+            : StatesCount(0)
+        {
+        }
+
+        inline unsigned Next(unsigned state, TChar character) const
+        {
+            return Transitions[state * Alphabet.ClassesCount
+                + Alphabet[static_cast<unsigned char>(character)]];
+        }
+
+        inline bool IsAccept(unsigned state) const
+        {
+            return AcceptStates[state / (sizeof(unsigned) * CHAR_BIT)]
+                >> (state % (sizeof(unsigned) * CHAR_BIT)) & 1;
+        }
+
+        inline void SetAccept(unsigned state)
+        {
+            AcceptStates[state / (sizeof(unsigned) * CHAR_BIT)] |=
+                1u << (state % (sizeof(unsigned) * CHAR_BIT));
+        }
+
+        inline typename TPatterns::const_iterator PatternsBegin(
+            unsigned state) const
+        {
+            return AcceptPatterns.begin() + PatternOffsets[state];
+        }
+
+        inline typename TPatterns::const_iterator PatternsEnd(
+            unsigned state) const
+        {
+            return AcceptPatterns.begin() + PatternOffsets[state + 1];
+        }
+    };
+
+    // transition by any character from [First, Last]
+    template <class TChar>
+    struct TNFATransition
+    {
+        TChar First;
+        TChar Last;
+        unsigned Target;
+
+        inline TNFATransition(TChar first = TChar(), TChar last = TChar(),
+            unsigned target = 0)
+            : First(first)
+            , Last(last)
+            , Target(target)
+        {
+        }
+
+        inline bool Contains(TChar character) const
+        {
+            return !(character < First) && !(Last < character);
+        }
+
+        inline bool operator < (const TNFATransition& other) const
+        {
+            if(First != other.First)
+            {
+                return First < other.First;
+            }
+            if(Last != other.Last)
+            {
+                return Last < other.Last;
+            }
+            return Target < other.Target;
+        }
+
+        inline bool operator == (const TNFATransition& other) const
+        {
+            return First == other.First && Last == other.Last
+                && Target == other.Target;
+        }
+    };
+
+    // compressed sparse row layout, built once the automaton is complete
+    template <class TChar>
+    struct TNFA
+    {
+        typedef TNFATransition<TChar> TTransition;
+        typedef std::vector<TTransition> TTransitions;
+        // transitions of all states, ordered by range and target state
+        // inside of each state, transitions entering the same state have
+        // the same ranges, character classes give several of them
+        TTransitions Transitions;
+
+        typedef std::vector<unsigned> TOffsets;
+        // state i transitions are [Offsets[i], Offsets[i + 1]), the last
+        // element is the total transitions count
+        TOffsets Offsets;
 
         typedef std::vector<unsigned> TAcceptStates;
         // ordered, not empty
         TAcceptStates AcceptStates;
+
+        typedef std::vector<unsigned> TPatterns;
+        // patterns accepted in AcceptStates[i] are [PatternOffsets[i],
+        // PatternOffsets[i + 1]) elements of AcceptPatterns, ordered
+        TOffsets PatternOffsets;
+        TPatterns AcceptPatterns;
+
+        inline unsigned StatesCount() const
+        {
+            return Offsets.size() - 1;
+        }
+
+        inline typename TTransitions::const_iterator Begin(unsigned state)
+            const
+        {
+            return Transitions.begin() + Offsets[state];
+        }
+
+        inline typename TTransitions::const_iterator End(unsigned state)
+            const
+        {
+            return Transitions.begin() + Offsets[state + 1];
+        }
+    };
+
+    // DFA state of leftmost-longest search, a key which starts with a flag
+    // telling whether new matches can still start, followed by groups of
+    // NFA states ordered by match start, each one closed by Separator
+    struct TStateGroups
+    {
+        typedef std::vector<unsigned> TKey;
+
+        enum
+        {
+            Separator = UINT_MAX
+        };
+
+        // builds the key from target groups ordered by match start, a state
+        // already kept by an earlier group is dropped from later ones, and
+        // neither later groups nor new starts can give the leftmost match
+        // once a group accepts, so they are dropped too
+        // the key consisting of the flag alone is the dead state, seen must
+        // have an element per NFA state, all false, and is left so
+        static void MakeKey(TKey& groups, bool starting,
+            const std::vector<bool>& accept, std::vector<bool>& seen,
+            TKey& key)
+        {
+            key.assign(1, 0);
+            bool accepted = false;
+            for(TKey::iterator begin = groups.begin();
+                begin != groups.end() && !accepted;)
+            {
+                const TKey::iterator end = std::find(begin, groups.end(),
+                    static_cast<unsigned>(Separator));
+                std::sort(begin, end);
+                const unsigned size = key.size();
+                for(TKey::const_iterator state = begin; state != end;
+                    ++state)
+                {
+                    if(!seen[*state])
+                    {
+                        seen[*state] = true;
+                        key.push_back(*state);
+                        accepted = accepted || accept[*state];
+                    }
+                }
+                if(key.size() != size)
+                {
+                    key.push_back(Separator);
+                }
+                begin = end == groups.end() ? end : end + 1;
+            }
+            // the NFA start state has no incoming transitions, so it is
+            // never met in other groups
+            if(starting && !accepted)
+            {
+                key.push_back(0);
+                key.push_back(Separator);
+                accepted = accept[0];
+            }
+            key[0] = starting && !accepted;
+            for(TKey::const_iterator state = key.begin() + 1,
+                end = key.end(); state != end; ++state)
+            {
+                if(*state != Separator)
+                {
+                    seen[*state] = false;
+                }
+            }
+        }
+
+        // beginning of the last group, the only one which can accept, its
+        // end is the last Separator
+        static TKey::const_iterator LastGroup(const TKey& key)
+        {
+            if(key.size() == 1)
+            {
+                return key.end();
+            }
+            TKey::const_iterator last = key.end() - 1;
+            while(last - 1 != key.begin() && *(last - 1) != Separator)
+            {
+                --last;
+            }
+            return last;
+        }
     };
 
+    // transition which also sets capture slots
     template <class TChar>
-    struct TDFA : TFA<TChar, std::map>
+    struct TTaggedTransition: TNFATransition<TChar>
     {
+        // slots set to the offset of the transition character are
+        // [TagsBegin, TagsEnd) elements of TTaggedNFA::Tags
+        unsigned TagsBegin;
+        unsigned TagsEnd;
+
+        inline TTaggedTransition(TChar first = TChar(), TChar last = TChar(),
+            unsigned target = 0, unsigned tagsBegin = 0,
+            unsigned tagsEnd = 0)
+            : TNFATransition<TChar>(first, last, target)
+            , TagsBegin(tagsBegin)
+            , TagsEnd(tagsEnd)
+        {
+        }
     };
 
+    // position automaton of a single pattern which also tracks capture
+    // groups, slot 2i is the start of group i and slot 2i + 1 is its end,
+    // group 0 is the whole match
+    // when several paths lead to the same state, the one using earlier
+    // transitions wins, this gives leftmost-first greedy submatches, except
+    // that loop iterations never match empty string
     template <class TChar>
-    struct TNFA : TFA<TChar, std::multimap>
+    struct TTaggedNFA
     {
+        typedef TTaggedTransition<TChar> TTransition;
+        typedef std::vector<TTransition> TTransitions;
+        // transitions of all states, in priority order inside of each
+        // state, state 0 is the start state
+        TTransitions Transitions;
+
+        typedef std::vector<unsigned> TOffsets;
+        // state i transitions are [Offsets[i], Offsets[i + 1])
+        TOffsets Offsets;
+
+        // slot numbers set by transitions and accept states
+        std::vector<unsigned> Tags;
+
+        std::vector<bool> AcceptStates;
+        // accept state i sets [FinalOffsets[i], FinalOffsets[i + 1])
+        // elements of Tags to the input end
+        TOffsets FinalOffsets;
+
+        unsigned GroupsCount;
+
+        inline unsigned StatesCount() const
+        {
+            return Offsets.size() - 1;
+        }
+
+        inline unsigned SlotsCount() const
+        {
+            return GroupsCount * 2;
+        }
+
+        inline typename TTransitions::const_iterator Begin(unsigned state)
+            const
+        {
+            return Transitions.begin() + Offsets[state];
+        }
+
+        inline typename TTransitions::const_iterator End(unsigned state)
+            const
+        {
+            return Transitions.begin() + Offsets[state + 1];
+        }
     };
 }
 
@@ -0,0 +1,221 @@
+#ifndef __LAZYDFA_HPP_2026_10_17__
+#define __LAZYDFA_HPP_2026_10_17__
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    struct TLazyDFAStats
+    {
+        unsigned long Hits;
+        unsigned long Misses;
+        unsigned long Flushes;
+
+        inline TLazyDFAStats()
+            : Hits(0)
+            , Misses(0)
+            , Flushes(0)
+        {
+        }
+    };
+
+    // builds DFA states from NFA state sets only when input reaches them,
+    // at most Capacity states are kept, the whole cache is flushed when it
+    // overflows, so state numbers returned before a flush become invalid
+    // states are either anchored state sets or leftmost-longest search
+    // keys described by TStateGroups, like ones of
+    // TDFAGenerator::CreateLeftmostLongestDFA
+    template <class TChar>
+    class TLazyDFA
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        typedef typename TNFA<TChar>::TTransitions TTransitions;
+
+        // ordered, without duplicates, or TStateGroups key
+        typedef std::vector<unsigned> TStateSet;
+        typedef std::map<TStateSet, unsigned> TStateSets;
+
+        static const unsigned Unknown = static_cast<unsigned>(-1);
+
+        // must outlive this object
+        const TNFA<TChar>& NFA;
+        const TAlphabet Alphabet;
+        const unsigned Capacity;
+        const bool LeftmostLongest;
+        std::vector<bool> AcceptNFAStates;
+        // all false between calls of TStateGroups::MakeKey
+        std::vector<bool> Seen;
+
+        TStateSets Sets;
+        std::vector<typename TStateSets::const_iterator> States;
+        // rows of Alphabet.ClassesCount targets, Unknown if not built yet
+        std::vector<unsigned> Transitions;
+        std::vector<bool> AcceptStates;
+        TLazyDFAStats Stats;
+
+        unsigned AddState(const TStateSet& set)
+        {
+            std::pair<typename TStateSets::iterator, bool> result =
+                Sets.insert(std::make_pair(set, States.size()));
+            if(result.second)
+            {
+                States.push_back(result.first);
+                Transitions.resize(States.size() * Alphabet.ClassesCount,
+                    Unknown);
+                // only the last group of a key can accept
+                bool accept = false;
+                for(TStateSet::const_iterator state = LeftmostLongest
+                    ? TStateGroups::LastGroup(set) : set.begin(),
+                    end = set.end(); state != end && !accept
+                    && *state != TStateGroups::Separator; ++state)
+                {
+                    accept = AcceptNFAStates[*state];
+                }
+                AcceptStates.push_back(accept);
+            }
+            return result.first->second;
+        }
+
+        void Flush()
+        {
+            Sets.clear();
+            States.clear();
+            Transitions.clear();
+            AcceptStates.clear();
+            TStateSet start(1, 0);
+            if(LeftmostLongest)
+            {
+                TStateSet groups;
+                TStateGroups::MakeKey(groups, true, AcceptNFAStates, Seen,
+                    start);
+            }
+            // dead key is the flag alone
+            AddState(TStateSet(LeftmostLongest ? 1 : 0, 0));
+            Transitions.assign(Alphabet.ClassesCount, DeadState);
+            AddState(start);
+        }
+
+        unsigned Build(unsigned state, TChar character)
+        {
+            ++Stats.Misses;
+            TStateSet target;
+            const TStateSet& set = States[state]->first;
+            for(TStateSet::const_iterator from = set.begin()
+                + LeftmostLongest, end = set.end(); from != end; ++from)
+            {
+                // targets of every group are kept apart
+                if(*from == TStateGroups::Separator)
+                {
+                    if(!target.empty()
+                        && target.back() != TStateGroups::Separator)
+                    {
+                        target.push_back(TStateGroups::Separator);
+                    }
+                    continue;
+                }
+                for(typename TTransitions::const_iterator transition =
+                    NFA.Begin(*from), end = NFA.End(*from);
+                    transition != end && !(character < transition->First);
+                    ++transition)
+                {
+                    if(!(transition->Last < character))
+                    {
+                        target.push_back(transition->Target);
+                    }
+                }
+            }
+            if(LeftmostLongest)
+            {
+                TStateSet key;
+                TStateGroups::MakeKey(target, set.front(), AcceptNFAStates,
+                    Seen, key);
+                target.swap(key);
+            }
+            else
+            {
+                std::sort(target.begin(), target.end());
+                target.erase(std::unique(target.begin(), target.end()),
+                    target.end());
+            }
+
+            if(Sets.find(target) == Sets.end() && States.size() == Capacity)
+            {
+                // source state row is lost too, only the target survives
+                ++Stats.Flushes;
+                Flush();
+                return AddState(target);
+            }
+            const unsigned result = AddState(target);
+            Transitions[state * Alphabet.ClassesCount
+                + Alphabet[static_cast<unsigned char>(character)]] = result;
+            return result;
+        }
+
+    public:
+        enum
+        {
+            DeadState = 0,
+            StartState = 1
+        };
+
+        // capacity includes dead and start states, automaton is anchored
+        // unless it is created for leftmost-longest search
+        TLazyDFA(const TNFA<TChar>& nfa, const TAlphabet& alphabet,
+            unsigned capacity = 4096, bool leftmostLongest = false)
+            : NFA(nfa)
+            , Alphabet(alphabet)
+            , Capacity(std::max(capacity, 3u))
+            , LeftmostLongest(leftmostLongest)
+            , AcceptNFAStates(nfa.StatesCount())
+            , Seen(nfa.StatesCount())
+        {
+            for(typename TNFA<TChar>::TAcceptStates::const_iterator state =
+                nfa.AcceptStates.begin(), end = nfa.AcceptStates.end();
+                state != end; ++state)
+            {
+                AcceptNFAStates[*state] = true;
+            }
+            Flush();
+        }
+
+        inline unsigned Next(unsigned state, TChar character)
+        {
+            const unsigned index = state * Alphabet.ClassesCount
+                + Alphabet[static_cast<unsigned char>(character)];
+            if(Transitions[index] != Unknown)
+            {
+                ++Stats.Hits;
+                return Transitions[index];
+            }
+            return Build(state, character);
+        }
+
+        inline bool IsAccept(unsigned state) const
+        {
+            return AcceptStates[state];
+        }
+
+        // number of currently cached states
+        inline unsigned StatesCount() const
+        {
+            return States.size();
+        }
+
+        inline const TLazyDFAStats& GetStats() const
+        {
+            return Stats;
+        }
+    };
+
+    template <class TChar>
+    const unsigned TLazyDFA<TChar>::Unknown;
+}
+
+#endif
+
@@ -1,13 +1,60 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ahocorasick.hpp"
+#include "alphabetgenerator.hpp"
+#include "dfagenerator.hpp"
+#include "dfamatcher.hpp"
+#include "dfaminimizer.hpp"
 #include "nfagenerator.hpp"
+#include "prefilter.hpp"
+#include "serialization.hpp"
+#include "teddy.hpp"
 #include "token.hpp"
+#include "utf8.hpp"
 using namespace NReinventedWheels;
 
+// graphviz label of a character, unprintable ones are shown as \xHH
+void PrintCharacter(std::ostream& output, char character)
+{
+    const unsigned char byte = character;
+    if(byte < ' ' || byte >= 0x7F || byte == '"' || byte == '\\')
+    {
+        output << "\\\\x" << "0123456789abcdef"[byte >> 4]
+            << "0123456789abcdef"[byte & 0xF];
+    }
+    else
+    {
+        output << character;
+    }
+}
+
+void PrintRange(std::ostream& output, char first, char last)
+{
+    PrintCharacter(output, first);
+    if(first != last)
+    {
+        output << '-';
+        PrintCharacter(output, last);
+    }
+}
+
 unsigned PrintGraph(const INode* root)
 {
     static unsigned p = 0;
@@ -34,6 +81,24 @@ unsigned PrintGraph(const INode* root)
                 output << "Closure";
                 children.push_back(PrintGraph(op->Children[0]));
                 break;
+            case TOperationType::Repetition:
+            {
+                const TRepetition* repetition =
+                    static_cast<const TRepetition*>(op);
+                output << "Repetition {" << repetition->Min << ',';
+                if(repetition->Max != TRepetition::Unbounded)
+                {
+                    output << repetition->Max;
+                }
+                output << '}';
+                children.push_back(PrintGraph(op->Children[0]));
+                break;
+            }
+            case TOperationType::Capture:
+                output << "Capture "
+                    << static_cast<const TCapture*>(op)->Index;
+                children.push_back(PrintGraph(op->Children[0]));
+                break;
         }
     }
     else
@@ -44,6 +109,18 @@ unsigned PrintGraph(const INode* root)
             const TCharacter<char>* c = static_cast<const TCharacter<char>*>(token);
             output << c->Character;
         }
+        else if(token->GetTokenType() == TTokenType::Class)
+        {
+            const TCharacterClass<char>* c =
+                static_cast<const TCharacterClass<char>*>(token);
+            output << '[';
+            for(const TCharacterClass<char>::TRange* range = c->Begin();
+                range != c->End(); ++range)
+            {
+                PrintRange(output, range->first, range->second);
+            }
+            output << ']';
+        }
         else
         {
             output << "ε";
@@ -59,18 +136,8 @@ unsigned PrintGraph(const INode* root)
     return curr;
 }
 
-int main(int argc, char* argv[])
+void PrintAutomaton(const TNFA<char>& nfa)
 {
-    if(argc != 2)
-    {
-        std::cerr << "usage: " << argv[0] << " regexp" << std::endl;
-        return 1;
-    }
-    const INode* root = Parse(argv[1], argv[1] + strlen(argv[1]));
-    std::cerr << "graph tree {\n";
-    PrintGraph(root);
-    std::cerr << "}\n";
-    TNFA<char> nfa = TNFAGenerator<char>::CreateNFA(root);
     std::cout << "digraph fsm {\n\trankdir=LR;\n\tnode [shape=doublecircle];";
     for(TNFA<char>::TAcceptStates::const_iterator iter =
         nfa.AcceptStates.begin(), end = nfa.AcceptStates.end(); iter != end;
@@ -79,15 +146,606 @@ int main(int argc, char* argv[])
         std::cout << " q" << *iter;
     }
     std::cout << ";\n\tnode [shape=circle];\n";
-    for(TNFA<char>::TStates::const_iterator state = nfa.States.begin(),
-        end = nfa.States.end(); state != end; ++state)
+    for(unsigned state = 0, end = nfa.StatesCount(); state != end; ++state)
     {
-        for(TNFA<char>::TState::const_iterator transition = state->begin(),
-            end = state->end(); transition != end; ++transition)
-        std::cout << "\tq" << (state - nfa.States.begin()) << " -> q"
-            << transition->second << " [ label = \"" << transition->first
-            << "\" ];\n";
+        for(TNFA<char>::TTransitions::const_iterator transition =
+            nfa.Begin(state), end = nfa.End(state); transition != end;
+            ++transition)
+        {
+            std::cout << "\tq" << state << " -> q" << transition->Target
+                << " [ label = \"";
+            PrintRange(std::cout, transition->First, transition->Last);
+            std::cout << "\" ];\n";
+        }
     }
     std::cout << "}\n";
 }
 
+struct TOptions
+{
+    bool Graph;
+    bool Count;
+    bool LineNumbers;
+    bool ByteOffsets;
+    bool Throughput;
+    bool Patterns;
+    bool FileNames;
+    unsigned Threads;
+};
+
+// prints lines containing a match, dfa must be unanchored TDFA or
+// TAhoCorasick
+// [begin, end) must start at a line start of the file starting at origin,
+// lineNumber lines precede it
+// if prefilter is set, only lines where it finds something are scanned
+// if patterns are requested, the whole line is scanned to find all of them
+// returns number of matching lines
+template <class TAutomaton>
+unsigned long ScanBuffer(const TAutomaton& dfa, const IPrefilter* prefilter,
+    const char* origin, const char* begin, const char* end,
+    unsigned long lineNumber, const char* name, const TOptions& options,
+    FILE* output)
+{
+    const bool matchesEmpty = dfa.IsAccept(TAutomaton::StartState);
+    std::vector<unsigned> patterns;
+    unsigned long matches = 0;
+    for(const char* line = begin; line != end;)
+    {
+        if(prefilter)
+        {
+            const char* candidate = prefilter->Find(line, end);
+            const char* lineStart = candidate;
+            while(lineStart != line && lineStart[-1] != '\n')
+            {
+                --lineStart;
+            }
+            if(options.LineNumbers)
+            {
+                lineNumber += std::count(line, lineStart, '\n');
+            }
+            if(candidate == end)
+            {
+                break;
+            }
+            line = lineStart;
+        }
+        ++lineNumber;
+        const char* pos = line;
+        bool matched = matchesEmpty;
+        for(unsigned state = TAutomaton::StartState;
+            !matched && pos != end && *pos != '\n'; ++pos)
+        {
+            state = dfa.Next(state, *pos);
+            matched = dfa.IsAccept(state);
+        }
+        const char* lineEnd = pos;
+        if(matched)
+        {
+            lineEnd = static_cast<const char*>(
+                memchr(pos, '\n', end - pos));
+            if(!lineEnd)
+            {
+                lineEnd = end;
+            }
+            ++matches;
+            if(!options.Count)
+            {
+                if(options.FileNames)
+                {
+                    fprintf(output, "%s:", name);
+                }
+                if(options.LineNumbers)
+                {
+                    fprintf(output, "%lu:", lineNumber);
+                }
+                if(options.ByteOffsets)
+                {
+                    fprintf(output, "%lu:",
+                        static_cast<unsigned long>(line - origin));
+                }
+                if(options.Patterns)
+                {
+                    patterns.clear();
+                    SearchPatternsDFA(dfa, line, lineEnd, patterns);
+                    for(std::vector<unsigned>::const_iterator pattern =
+                        patterns.begin(); pattern != patterns.end();
+                        ++pattern)
+                    {
+                        fprintf(output, pattern == patterns.begin()
+                            ? "%u" : ",%u", *pattern);
+                    }
+                    putc(':', output);
+                }
+                fwrite(line, 1, lineEnd - line, output);
+                putc('\n', output);
+            }
+        }
+        line = lineEnd == end ? end : lineEnd + 1;
+    }
+    return matches;
+}
+
+// part of a file scanned by its own thread, matching lines are collected
+// in memory and printed once all parts are done
+template <class TAutomaton>
+struct TScanJob
+{
+    const TAutomaton* DFA;
+    const IPrefilter* Prefilter;
+    const char* Origin;
+    const char* Begin;
+    const char* End;
+    const char* Name;
+    const TOptions* Options;
+    // lines preceding the part, counted by the first pass
+    unsigned long LineNumber;
+    unsigned long Matches;
+    FILE* Output;
+    char* Text;
+    size_t Size;
+
+    static void* CountLines(void* data)
+    {
+        TScanJob* job = static_cast<TScanJob*>(data);
+        job->LineNumber = std::count(job->Begin, job->End, '\n');
+        return 0;
+    }
+
+    static void* Scan(void* data)
+    {
+        TScanJob* job = static_cast<TScanJob*>(data);
+        job->Matches = ScanBuffer(*job->DFA, job->Prefilter, job->Origin,
+            job->Begin, job->End, job->LineNumber, job->Name, *job->Options,
+            job->Output);
+        fflush(job->Output);
+        return 0;
+    }
+};
+
+// runs function for every job, the first one in the calling thread, jobs
+// which failed to get a thread are run there too
+template <class TJob>
+void RunJobs(std::vector<TJob>& jobs, void* (*function)(void*))
+{
+    std::vector<pthread_t> threads(jobs.size());
+    std::vector<bool> started(jobs.size());
+    for(unsigned i = 1; i < jobs.size(); ++i)
+    {
+        started[i] = !pthread_create(&threads[i], 0, function, &jobs[i]);
+    }
+    function(&jobs.front());
+    for(unsigned i = 1; i < jobs.size(); ++i)
+    {
+        if(started[i])
+        {
+            pthread_join(threads[i], 0);
+        }
+        else
+        {
+            function(&jobs[i]);
+        }
+    }
+}
+
+// splits buffer between threads at line boundaries, lines are scanned from
+// the start state, so parts do not depend on each other, small buffers are
+// scanned by the calling thread
+// returns number of matching lines
+template <class TAutomaton>
+unsigned long ScanParallel(const TAutomaton& dfa,
+    const IPrefilter* prefilter, const char* begin, const char* end,
+    const char* name, const TOptions& options)
+{
+    const size_t MinPart = 1 << 20;
+    const size_t size = end - begin;
+    const unsigned count = std::min<size_t>(options.Threads,
+        size / MinPart + 1);
+    std::vector<TScanJob<TAutomaton> > jobs(count);
+    const char* partBegin = begin;
+    for(unsigned i = 0; i < count; ++i)
+    {
+        const char* partEnd = begin + size * (i + 1) / count;
+        if(partEnd < partBegin)
+        {
+            partEnd = partBegin;
+        }
+        else if(partEnd != end)
+        {
+            partEnd = static_cast<const char*>(
+                memchr(partEnd, '\n', end - partEnd));
+            partEnd = partEnd ? partEnd + 1 : end;
+        }
+        TScanJob<TAutomaton> job = {&dfa, prefilter, begin, partBegin,
+            partEnd, name, &options, 0, 0, 0, 0, 0};
+        jobs[i] = job;
+        partBegin = partEnd;
+    }
+    bool buffered = count > 1;
+    for(unsigned i = 0; buffered && i < count; ++i)
+    {
+        jobs[i].Output = open_memstream(&jobs[i].Text, &jobs[i].Size);
+        buffered = jobs[i].Output;
+    }
+    unsigned long matches = 0;
+    if(buffered)
+    {
+        if(options.LineNumbers)
+        {
+            RunJobs(jobs, &TScanJob<TAutomaton>::CountLines);
+            for(unsigned i = count - 1; i; --i)
+            {
+                jobs[i].LineNumber = jobs[i - 1].LineNumber;
+            }
+            jobs.front().LineNumber = 0;
+            for(unsigned i = 1; i < count; ++i)
+            {
+                jobs[i].LineNumber += jobs[i - 1].LineNumber;
+            }
+        }
+        RunJobs(jobs, &TScanJob<TAutomaton>::Scan);
+    }
+    for(unsigned i = 0; i < count; ++i)
+    {
+        if(jobs[i].Output)
+        {
+            fclose(jobs[i].Output);
+            fwrite(jobs[i].Text, 1, jobs[i].Size, stdout);
+            free(jobs[i].Text);
+        }
+        matches += jobs[i].Matches;
+    }
+    if(!buffered)
+    {
+        matches = ScanBuffer(dfa, prefilter, begin, begin, end, 0, name,
+            options, stdout);
+    }
+    return matches;
+}
+
+// maps the whole file into memory and scans it in place
+template <class TAutomaton>
+bool ScanFile(const TAutomaton& dfa, const IPrefilter* prefilter,
+    const char* name, const TOptions& options, unsigned long& matches,
+    double& bytes)
+{
+    const int fd = open(name, O_RDONLY);
+    if(fd == -1)
+    {
+        std::cerr << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) == -1)
+    {
+        std::cerr << name << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    unsigned long fileMatches = 0;
+    if(info.st_size)
+    {
+        void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED)
+        {
+            std::cerr << name << ": " << strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+        madvise(data, info.st_size, MADV_SEQUENTIAL);
+        const char* begin = static_cast<const char*>(data);
+        fileMatches = ScanParallel(dfa, prefilter, begin,
+            begin + info.st_size, name, options);
+        munmap(data, info.st_size);
+        bytes += info.st_size;
+    }
+    close(fd);
+    if(options.Count)
+    {
+        if(options.FileNames)
+        {
+            printf("%s:", name);
+        }
+        printf("%lu\n", fileMatches);
+    }
+    matches += fileMatches;
+    return true;
+}
+
+inline double Now()
+{
+    timeval time;
+    gettimeofday(&time, 0);
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+// returns grep exit code
+template <class TAutomaton>
+int ScanFiles(const TAutomaton& dfa, const IPrefilter* prefilter,
+    char* files[], int count, TOptions& options)
+{
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    options.FileNames = count > 1;
+    unsigned long matches = 0;
+    double bytes = 0;
+    bool failed = false;
+    const double start = Now();
+    for(int i = 0; i < count; ++i)
+    {
+        failed |= !ScanFile(dfa, prefilter, files[i], options, matches,
+            bytes);
+    }
+    fflush(stdout);
+    if(options.Throughput)
+    {
+        const double elapsed = Now() - start;
+        std::cerr << bytes << " bytes in " << elapsed << " s, "
+            << bytes / elapsed / 1e9 << " GB/s" << std::endl;
+    }
+    return failed ? 2 : !matches;
+}
+
+// scans files with automaton saved by -w, image is used in place
+int ScanImage(const char* image, char* files[], int count,
+    TOptions& options)
+{
+    const int fd = open(image, O_RDONLY);
+    if(fd == -1)
+    {
+        std::cerr << image << ": " << strerror(errno) << std::endl;
+        return 2;
+    }
+    struct stat info;
+    if(fstat(fd, &info) == -1)
+    {
+        std::cerr << image << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return 2;
+    }
+    void* data = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        std::cerr << image << ": " << strerror(errno) << std::endl;
+        return 2;
+    }
+    int result = 2;
+    try
+    {
+        const TDFAView<char> dfa(data, info.st_size);
+        if(options.Throughput)
+        {
+            std::cerr << "dfa states: " << dfa.StatesCount()
+                << ", byte classes: " << dfa.ClassesCount() << std::endl;
+        }
+        result = ScanFiles(dfa, 0, files, count, options);
+    }
+    catch(const std::logic_error& error)
+    {
+        std::cerr << image << ": " << error.what() << std::endl;
+    }
+    munmap(data, info.st_size);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    TOptions options = TOptions();
+    options.Threads = 1;
+    std::vector<const char*> patterns;
+    const char* save = 0;
+    const char* load = 0;
+    bool utf8 = false;
+    for(int option; (option = getopt(argc, argv, "gcnbtpue:w:r:j:")) != -1;)
+    {
+        switch(option)
+        {
+            case 'e':
+                patterns.push_back(optarg);
+                break;
+
+            case 'w':
+                save = optarg;
+                break;
+
+            case 'r':
+                load = optarg;
+                break;
+
+            case 'p':
+                options.Patterns = true;
+                break;
+
+            case 'g':
+                options.Graph = true;
+                break;
+
+            case 'u':
+                utf8 = true;
+                break;
+
+            case 'c':
+                options.Count = true;
+                break;
+
+            case 'n':
+                options.LineNumbers = true;
+                break;
+
+            case 'b':
+                options.ByteOffsets = true;
+                break;
+
+            case 't':
+                options.Throughput = true;
+                break;
+
+            case 'j':
+                options.Threads = strtoul(optarg, 0, 10);
+                if(!options.Threads)
+                {
+                    argc = 0;
+                }
+                break;
+
+            default:
+                argc = 0;
+                break;
+        }
+    }
+    if(load && argc)
+    {
+        return ScanImage(load, argv + optind, argc - optind, options);
+    }
+    if(patterns.empty() && optind < argc)
+    {
+        patterns.push_back(argv[optind++]);
+    }
+    if(patterns.empty())
+    {
+        std::cerr << "usage: " << argv[0]
+            << " [-cnbtpu] [-j threads] regexp [file...]\n"
+            "       " << argv[0] << " [-cnbtpu] [-j threads] -e regexp... "
+            "[file...]\n"
+            "       " << argv[0] << " [-cnbtp] [-j threads] -r image "
+            "[file...]\n"
+            "       " << argv[0] << " [-u] -w image regexp...\n"
+            "       " << argv[0] << " [-u] -g regexp\n"
+            "\t-e\tadd pattern, patterns are numbered from 0\n"
+            "\t-w\tsave compiled automaton to image\n"
+            "\t-r\tscan with automaton from image instead of patterns\n"
+            "\t-c\tprint only matching lines count\n"
+            "\t-n\tprefix lines with line numbers\n"
+            "\t-b\tprefix lines with byte offsets\n"
+            "\t-p\tprefix lines with numbers of matching patterns\n"
+            "\t-t\treport scan throughput to stderr\n"
+            "\t-u\tpatterns and input are UTF-8, classes and . match "
+            "characters\n"
+            "\t-j\tsplit every file between this many threads\n"
+            "\t-g\tprint parse tree and automaton as graphviz\n";
+        return 2;
+    }
+    TNodeArena arena;
+    std::vector<const INode*> roots;
+    try
+    {
+        for(std::vector<const char*>::const_iterator pattern =
+            patterns.begin(); pattern != patterns.end(); ++pattern)
+        {
+            if(!utf8)
+            {
+                roots.push_back(Parse(*pattern,
+                    *pattern + strlen(*pattern), arena));
+                continue;
+            }
+            // the automaton is built over bytes of UTF-8 sequences, so
+            // the input is scanned as is
+            std::vector<wchar_t> characters;
+            DecodeUtf8(*pattern, *pattern + strlen(*pattern), characters);
+            roots.push_back(CompileUtf8<wchar_t>(Parse(characters.begin(),
+                characters.end(), arena), arena));
+        }
+    }
+    catch(const std::logic_error& error)
+    {
+        std::cerr << argv[0] << ": " << error.what() << std::endl;
+        return 2;
+    }
+    // plain strings alternations are prefiltered by all of their literals
+    // and huge ones skip subset construction, match can not span lines,
+    // so literals with newlines are useless
+    TLiteralSetAnalyzer<char>::TLiterals literals;
+    std::vector<std::string> strings;
+    bool multiline = false;
+    const bool literalSet =
+        TLiteralSetAnalyzer<char>::GetLiterals(roots, literals);
+    for(TLiteralSetAnalyzer<char>::TLiterals::const_iterator literal =
+        literals.begin(); literalSet && literal != literals.end(); ++literal)
+    {
+        strings.push_back(literal->first);
+        multiline |= literal->first.find('\n') != std::string::npos;
+    }
+    std::auto_ptr<IPrefilter> prefilter;
+    if(literalSet && !multiline && strings.size() > 1
+        && TTeddy::IsSuitable(strings))
+    {
+        prefilter.reset(new TTeddy(strings));
+    }
+    else if(roots.size() == 1)
+    {
+        // several patterns have no common required literal in general
+        const std::string literal =
+            TLiteralAnalyzer<char>::GetRequiredLiteral(roots.front());
+        if(!literal.empty() && literal.find('\n') == std::string::npos)
+        {
+            prefilter.reset(new TPrefilter(literal));
+            if(options.Throughput)
+            {
+                std::cerr << "required literal: " << literal << std::endl;
+            }
+        }
+    }
+
+    // dense automaton is faster to run, but subset construction time grows
+    // quickly with dictionary size
+    const unsigned MaxDenseLiterals = 64;
+    if(literalSet && literals.size() > MaxDenseLiterals && !options.Graph
+        && !save)
+    {
+        const TAhoCorasick<char> automaton(literals);
+        if(options.Throughput)
+        {
+            std::cerr << "literals: " << literals.size()
+                << ", aho-corasick states: " << automaton.StatesCount()
+                << std::endl;
+        }
+        return ScanFiles(automaton, prefilter.get(), argv + optind,
+            argc - optind, options);
+    }
+
+    // all patterns are compiled into one automaton, so the input is
+    // scanned once however many of them there are
+    TNFA<char> nfa = TNFAGenerator<char>::CreateNFA(roots);
+    if(options.Graph)
+    {
+        std::cerr << "graph tree {\n";
+        for(std::vector<const INode*>::const_iterator root = roots.begin();
+            root != roots.end(); ++root)
+        {
+            PrintGraph(*root);
+        }
+        std::cerr << "}\n";
+        PrintAutomaton(nfa);
+    }
+
+    TMinimizationStats stats;
+    const TAlphabet alphabet =
+        TAlphabetGenerator<char>::CreateAlphabet(roots);
+    const TDFA<char> dfa = TDFAMinimizer<char>::Minimize(
+        TDFAGenerator<char>::CreateDFA(nfa, alphabet, true), &stats);
+    if(options.Graph || options.Throughput)
+    {
+        std::cerr << "dfa states: " << stats.StatesBefore << " -> "
+            << stats.StatesAfter << ", byte classes: "
+            << alphabet.ClassesCount << std::endl;
+    }
+    if(options.Graph)
+    {
+        return 0;
+    }
+    if(save)
+    {
+        std::ofstream output(save, std::ios::binary);
+        SaveDFA(dfa, output);
+        output.close();
+        if(!output)
+        {
+            std::cerr << save << ": " << strerror(errno) << std::endl;
+            return 2;
+        }
+        return 0;
+    }
+
+    return ScanFiles(dfa, prefilter.get(), argv + optind, argc - optind,
+        options);
+}
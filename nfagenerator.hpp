@@ -2,209 +2,395 @@
 #define __NFAGENRATOR_HPP_2011_10_13__
 
 #include <algorithm>
-#include <functional>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "fsm.hpp"
 #include "token.hpp"
 
 namespace NReinventedWheels
 {
+    // builds Glushkov position automaton: state 0 is the start state and
+    // every character or class of the pattern is a state of its own,
+    // entered by its ranges only, so state numbers are final from the
+    // beginning and no intermediate automata are created
     template <class TChar>
     class TNFAGenerator
     {
-        typedef typename TNFA<TChar>::TState TState;
-        typedef typename TNFA<TChar>::TStates TStates;
-        typedef typename TNFA<TChar>::TAcceptStates TAcceptStates;
+        typedef std::vector<unsigned> TPositions;
+        typedef std::pair<unsigned, unsigned> TEdge;
+        typedef std::vector<TEdge> TEdges;
 
-        // moves all states to the first list
-        static void ConcatenateStates(TStates& first, TStates& second)
+        // ranges entering every state, state i ranges are
+        // [Offsets[i], Offsets[i + 1]) elements of Ranges
+        struct TLabels
         {
-            typename TStates::size_type size = first.size();
-            first.insert(first.end(), second.size(), TState());
-            for(typename TStates::iterator from = second.begin(),
-                end = second.end(), to = first.begin() + size; from != end;
-                ++from, ++to)
-            {
-                for(typename TState::iterator transition = from->begin(),
-                    end = from->end(); transition != end; ++transition)
-                {
-                    transition->second += size;
-                }
-                to->swap(*from);
-            }
-        }
+            std::vector<std::pair<TChar, TChar> > Ranges;
+            std::vector<unsigned> Offsets;
 
-        static TNFA<TChar> ConcatenateNFAs(TNFA<TChar> first,
-            TNFA<TChar> second)
-        {
-            // TODO: elide 'second' start state if there is no return to it
-            typename TStates::size_type size = first.States.size();
-            ConcatenateStates(first.States, second.States);
+            inline unsigned StatesCount() const
+            {
+                return Offsets.size() - 1;
+            }
 
-            TNFA<TChar> result;
-            std::transform(second.AcceptStates.begin(),
-                second.AcceptStates.end(),
-                second.AcceptStates.begin(),
-                std::bind1st(std::plus<unsigned>(), size));
-            if(second.AcceptStates.front() == size)
+            inline void AddState()
             {
-                result.AcceptStates = first.AcceptStates;
-                result.AcceptStates.insert(result.AcceptStates.end(),
-                    second.AcceptStates.begin(), second.AcceptStates.end());
+                Offsets.push_back(Ranges.size());
             }
-            else
+        };
+
+        struct TInfo
+        {
+            // node matches empty string
+            bool Nullable;
+            // positions which can start and end node matches
+            TPositions First;
+            TPositions Last;
+        };
+
+        // moves positions from the second list to the first one, the smaller
+        // list is copied
+        static inline void Unite(TPositions& first, TPositions& second)
+        {
+            if(first.size() < second.size())
             {
-                result.AcceptStates.swap(second.AcceptStates);
+                first.swap(second);
             }
+            first.insert(first.end(), second.begin(), second.end());
+        }
 
-            result.States.swap(first.States);
-            const TState& start = result.States[size];
-            for(typename TAcceptStates::const_iterator state =
-                first.AcceptStates.begin(), end = first.AcceptStates.end();
-                state != end; ++state)
+        // every position from 'from' can be followed by every position from
+        // 'to'
+        static inline void Connect(TEdges& edges, const TPositions& from,
+            const TPositions& to)
+        {
+            for(TPositions::const_iterator source = from.begin(),
+                end = from.end(); source != end; ++source)
             {
-                if (*state == 1)
-                {
-                    TState tmp;
-                    tmp.swap(result.States[*state]);
-                    tmp.insert(start.begin(), start.end());
-                    result.States[*state].swap(tmp);
-                }
-                else
+                for(TPositions::const_iterator target = to.begin(),
+                    end = to.end(); target != end; ++target)
                 {
-                    result.States[*state].insert(start.begin(), start.end());
+                    edges.push_back(TEdge(*source, *target));
                 }
             }
-            return result;
         }
 
-        static inline TNFA<TChar> AlternateNFAs(TNFA<TChar> first,
-            TNFA<TChar> second)
+        // concatenation of left and right is placed into left
+        static void Concatenate(TEdges& edges, TInfo& left, TInfo& right)
         {
-            // TODO: elide start state if there is no return to it
-            TNFA<TChar> result;
-            typename TStates::size_type size = first.States.size();
-            result.States.reserve(1 + size + second.States.size());
-            result.States.push_back(TState());
-            ConcatenateStates(result.States, first.States);
-            ConcatenateStates(result.States, second.States);
-            const bool acceptStartState =
-                !(first.AcceptStates.front() && second.AcceptStates.front());
-            // automatically fills start state if required
-            result.AcceptStates.resize(acceptStartState
-                + first.AcceptStates.size() + second.AcceptStates.size());
-            typename TAcceptStates::iterator acceptStatesEnd = std::transform(
-                first.AcceptStates.begin(),
-                first.AcceptStates.end(),
-                result.AcceptStates.begin() + acceptStartState,
-                std::bind1st(std::plus<unsigned>(), 1));
-            std::transform(second.AcceptStates.begin(),
-                second.AcceptStates.end(),
-                acceptStatesEnd,
-                std::bind1st(std::plus<unsigned>(), 1 + size));
-            TState& start = result.States.front();
-            start = result.States[1];
-            const TState& secondStart = result.States[1 + size];
-            start.insert(secondStart.begin(), secondStart.end());
-            return result;
+            Connect(edges, left.Last, right.First);
+            if(left.Nullable)
+            {
+                Unite(left.First, right.First);
+            }
+            if(right.Nullable)
+            {
+                Unite(right.Last, left.Last);
+            }
+            left.Last.swap(right.Last);
+            left.Nullable &= right.Nullable;
         }
 
-        static TNFA<TChar> ClosureNFA(TNFA<TChar> nfa)
+        // info of copy of the node with positions shifted by offset
+        static void Shift(const TInfo& info, unsigned offset, TInfo& result)
         {
-            // TODO: elide start state if existing one already acceptable
-            TNFA<TChar> result;
-            typename TStates::size_type size = nfa.States.size();
-            result.States.reserve(1 + size);
-            result.States.push_back(TState());
-            ConcatenateStates(result.States, nfa.States);
-            // automatically fills start state
-            result.AcceptStates.resize(1 + nfa.AcceptStates.size());
-            std::transform(nfa.AcceptStates.begin(), nfa.AcceptStates.end(),
-                result.AcceptStates.begin() + 1,
-                std::bind1st(std::plus<unsigned>(), 1));
-            const TState& start = result.States[1];
-            result.States.front() = start;
-            for(typename TAcceptStates::const_iterator state =
-                result.AcceptStates.begin() + 1, end =
-                result.AcceptStates.end(); state != end; ++state)
-            {
-                if (*state == 1)
+            result.Nullable = info.Nullable;
+            result.First = info.First;
+            result.Last = info.Last;
+            for(unsigned i = 0; i < result.First.size(); ++i)
+            {
+                result.First[i] += offset;
+            }
+            for(unsigned i = 0; i < result.Last.size(); ++i)
+            {
+                result.Last[i] += offset;
+            }
+        }
+
+        // replaces info of the repeated node, whose positions start at
+        // state and whose edges start at edge, with info of repetition
+        // every further copy gets positions and edges of its own, optional
+        // copies are nested like x(x(x)?)?, so that each of them is only
+        // connected to the next one and the automaton size is linear in
+        // the bound, unless the repeated node matches empty string
+        static void Repeat(const TRepetition* repetition, unsigned state,
+            unsigned edge, TLabels& labels, TEdges& edges, TInfo& info)
+        {
+            if(!repetition->Max)
+            {
+                info.Nullable = true;
+                info.First.clear();
+                info.Last.clear();
+                return;
+            }
+            const bool unbounded =
+                repetition->Max == TRepetition::Unbounded;
+            const unsigned copies = unbounded
+                ? std::max(repetition->Min, 1u) : repetition->Max;
+            const unsigned size = labels.StatesCount() - state;
+            const unsigned edgesEnd = edges.size();
+            for(unsigned copy = 1; copy < copies; ++copy)
+            {
+                for(unsigned i = state; i < state + size; ++i)
                 {
-                    TState tmp;
-                    tmp.swap(result.States[*state]);
-                    tmp.insert(start.begin(), start.end());
-                    result.States[*state].swap(tmp);
+                    for(unsigned range = labels.Offsets[i];
+                        range < labels.Offsets[i + 1]; ++range)
+                    {
+                        const std::pair<TChar, TChar> copied =
+                            labels.Ranges[range];
+                        labels.Ranges.push_back(copied);
+                    }
+                    labels.AddState();
                 }
-                else
+                for(unsigned i = edge; i < edgesEnd; ++i)
                 {
-                    result.States[*state].insert(start.begin(), start.end());
+                    edges.push_back(TEdge(edges[i].first + copy * size,
+                        edges[i].second + copy * size));
                 }
             }
-            return result;
-        }
 
-        static inline TNFA<TChar> CreateCharacterNFA(const TChar& character)
-        {
-            TNFA<TChar> result;
-            result.States.resize(2);
-            result.States.front().insert(std::make_pair(character, 1));
-            result.AcceptStates.push_back(1);
-            return result;
+            // built from the last copy backwards
+            TInfo result;
+            Shift(info, (copies - 1) * size, result);
+            if(unbounded)
+            {
+                Connect(edges, result.Last, result.First);
+            }
+            result.Nullable |= copies - 1 >= repetition->Min;
+            for(unsigned copy = copies - 1; copy-- > 0;)
+            {
+                TInfo left;
+                Shift(info, copy * size, left);
+                Concatenate(edges, left, result);
+                left.Nullable |= copy >= repetition->Min;
+                std::swap(left, result);
+            }
+            std::swap(info, result);
         }
 
-        static inline TNFA<TChar> CreateEmptyNFA()
+        // converts edges list into compressed sparse row layout, every
+        // edge becomes a transition per range of its target
+        static void Freeze(TNFA<TChar>& result, const TEdges& edges,
+            const TLabels& labels)
         {
-            TNFA<TChar> result;
-            result.States.push_back(TState());
-            result.AcceptStates.push_back(0);
-            return result;
+            const unsigned states = labels.StatesCount();
+            result.Offsets.assign(states + 1, 0);
+            for(typename TEdges::const_iterator edge = edges.begin(),
+                end = edges.end(); edge != end; ++edge)
+            {
+                result.Offsets[edge->first + 1] +=
+                    labels.Offsets[edge->second + 1]
+                    - labels.Offsets[edge->second];
+            }
+            for(unsigned state = 0; state < states; ++state)
+            {
+                result.Offsets[state + 1] += result.Offsets[state];
+            }
+
+            std::vector<unsigned> fill(result.Offsets.begin(),
+                result.Offsets.end() - 1);
+            result.Transitions.resize(result.Offsets.back());
+            for(typename TEdges::const_iterator edge = edges.begin(),
+                end = edges.end(); edge != end; ++edge)
+            {
+                for(unsigned range = labels.Offsets[edge->second];
+                    range < labels.Offsets[edge->second + 1]; ++range)
+                {
+                    result.Transitions[fill[edge->first]++] = typename
+                        TNFA<TChar>::TTransition(
+                            labels.Ranges[range].first,
+                            labels.Ranges[range].second, edge->second);
+                }
+            }
+
+            // nested closures produce duplicate edges
+            unsigned size = 0;
+            for(unsigned state = 0; state < states; ++state)
+            {
+                const typename TNFA<TChar>::TTransitions::iterator begin =
+                    result.Transitions.begin() + result.Offsets[state];
+                const typename TNFA<TChar>::TTransitions::iterator end =
+                    result.Transitions.begin() + result.Offsets[state + 1];
+                std::sort(begin, end);
+                result.Offsets[state] = size;
+                size = std::copy(begin, std::unique(begin, end),
+                    result.Transitions.begin() + size)
+                    - result.Transitions.begin();
+            }
+            result.Offsets.back() = size;
+            result.Transitions.resize(size);
         }
 
-    public:
-        static inline TNFA<TChar> CreateNFA(const INode* root)
+        // computes pattern info, adds its characters and classes as new
+        // states
+        static void AddPattern(const INode* root, TLabels& labels,
+            TEdges& edges, TInfo& result)
         {
-            if(root->GetNodeType() == TNodeType::Operation)
+            // post-order traversal, second element is true when children
+            // are already processed and their infos are on the top of infos
+            std::vector<std::pair<const INode*, bool> > stack;
+            std::vector<TInfo> infos;
+            // first state and edge of every repetition being processed
+            std::vector<TEdge> repetitions;
+            stack.push_back(std::make_pair(root, false));
+            while(!stack.empty())
             {
+                const INode* node = stack.back().first;
+                const bool visited = stack.back().second;
+                stack.pop_back();
+                if(node->GetNodeType() == TNodeType::Token)
+                {
+                    infos.push_back(TInfo());
+                    TInfo& info = infos.back();
+                    const TTokenType::TType type =
+                        static_cast<const IToken*>(node)->GetTokenType();
+                    if(type == TTokenType::Empty)
+                    {
+                        info.Nullable = true;
+                        continue;
+                    }
+                    info.Nullable = false;
+                    info.First.push_back(labels.StatesCount());
+                    info.Last.push_back(labels.StatesCount());
+                    if(type == TTokenType::Character)
+                    {
+                        const TChar character = static_cast<
+                            const TCharacter<TChar>*>(node)->Character;
+                        labels.Ranges.push_back(std::make_pair(character,
+                            character));
+                    }
+                    else
+                    {
+                        const TCharacterClass<TChar>* characterClass =
+                            static_cast<const TCharacterClass<TChar>*>(node);
+                        labels.Ranges.insert(labels.Ranges.end(),
+                            characterClass->Begin(), characterClass->End());
+                    }
+                    labels.AddState();
+                    continue;
+                }
+
                 const IOperation* operation =
-                    static_cast<const IOperation*>(root);
+                    static_cast<const IOperation*>(node);
+                if(!visited)
+                {
+                    if(operation->GetOperationType()
+                        == TOperationType::Repetition)
+                    {
+                        repetitions.push_back(TEdge(labels.StatesCount(),
+                            edges.size()));
+                    }
+                    stack.push_back(std::make_pair(node, true));
+                    for(int i = 1; i >= 0; --i)
+                    {
+                        if(operation->Children[i])
+                        {
+                            stack.push_back(std::make_pair(
+                                operation->Children[i], false));
+                        }
+                    }
+                    continue;
+                }
+
                 switch(operation->GetOperationType())
                 {
                     case TOperationType::Concatenation:
-                        return ConcatenateNFAs(
-                            CreateNFA(operation->Children[0]),
-                            CreateNFA(operation->Children[1]));
+                        Concatenate(edges, infos[infos.size() - 2],
+                            infos.back());
+                        infos.pop_back();
+                        break;
 
                     case TOperationType::Alternation:
-                        // TODO: provide ability to alternate vector of NFAs
-                        return AlternateNFAs(
-                            CreateNFA(operation->Children[0]),
-                            CreateNFA(operation->Children[1]));
+                    {
+                        TInfo& left = infos[infos.size() - 2];
+                        TInfo& right = infos.back();
+                        Unite(left.First, right.First);
+                        Unite(left.Last, right.Last);
+                        left.Nullable |= right.Nullable;
+                        infos.pop_back();
+                        break;
+                    }
 
                     case TOperationType::Closure:
-                        return ClosureNFA(CreateNFA(operation->Children[0]));
+                        Connect(edges, infos.back().Last, infos.back().First);
+                        infos.back().Nullable = true;
+                        break;
+
+                    case TOperationType::Repetition:
+                        Repeat(static_cast<const TRepetition*>(operation),
+                            repetitions.back().first,
+                            repetitions.back().second, labels, edges,
+                            infos.back());
+                        repetitions.pop_back();
+                        break;
+
+                    case TOperationType::Capture:
+                        break;
 
                     default:
                         throw std::logic_error("unknown operation type");
                 }
             }
-            else
+            result.Nullable = infos.back().Nullable;
+            result.First.swap(infos.back().First);
+            result.Last.swap(infos.back().Last);
+        }
+
+    public:
+        // alternation of all patterns sharing the start state, accept
+        // states know which of the patterns they accept, pattern id is its
+        // index in roots, which must not be empty
+        // takes time proportional to patterns size plus transitions count
+        static TNFA<TChar> CreateNFA(const std::vector<const INode*>& roots)
+        {
+            // state 0 has no incoming transitions
+            TLabels labels;
+            labels.Offsets.assign(2, 0);
+            TEdges edges;
+            // (accept state, pattern) pairs
+            TEdges accepts;
+            const TPositions start(1, 0);
+            for(unsigned pattern = 0; pattern < roots.size(); ++pattern)
             {
-                const IToken* token = static_cast<const IToken*>(root);
-                if(token->GetTokenType() == TTokenType::Character)
+                TInfo info;
+                AddPattern(roots[pattern], labels, edges, info);
+                Connect(edges, start, info.First);
+                if(info.Nullable)
+                {
+                    accepts.push_back(TEdge(0, pattern));
+                }
+                for(TPositions::const_iterator state = info.Last.begin(),
+                    end = info.Last.end(); state != end; ++state)
                 {
-                    const TCharacter<TChar>* character =
-                        static_cast<const TCharacter<TChar>*>(token);
-                    return CreateCharacterNFA(character->Character);
+                    accepts.push_back(TEdge(*state, pattern));
                 }
-                else
+            }
+
+            TNFA<TChar> result;
+            Freeze(result, edges, labels);
+            std::sort(accepts.begin(), accepts.end());
+            for(typename TEdges::const_iterator accept = accepts.begin(),
+                end = accepts.end(); accept != end; ++accept)
+            {
+                if(result.AcceptStates.empty()
+                    || result.AcceptStates.back() != accept->first)
                 {
-                    return CreateEmptyNFA();
+                    result.AcceptStates.push_back(accept->first);
+                    result.PatternOffsets.push_back(
+                        result.AcceptPatterns.size());
                 }
+                result.AcceptPatterns.push_back(accept->second);
             }
+            result.PatternOffsets.push_back(result.AcceptPatterns.size());
+            return result;
+        }
+
+        static inline TNFA<TChar> CreateNFA(const INode* root)
+        {
+            return CreateNFA(std::vector<const INode*>(1, root));
         }
     };
 }
 
 #endif
-
@@ -0,0 +1,196 @@
+#ifndef __NFAMATCHER_HPP_2026_10_17__
+#define __NFAMATCHER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <vector>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // set of integers from [0, capacity) with O(1) insertion, lookup and
+    // clear, elements are iterated in insertion order
+    class TSparseSet
+    {
+        std::vector<unsigned> Dense;
+        std::vector<unsigned> Sparse;
+        unsigned Size;
+
+    public:
+        typedef std::vector<unsigned>::const_iterator const_iterator;
+
+        inline explicit TSparseSet(unsigned capacity = 0)
+            : Dense(capacity)
+            , Sparse(capacity)
+            , Size(0)
+        {
+        }
+
+        inline bool Contains(unsigned value) const
+        {
+            const unsigned index = Sparse[value];
+            return index < Size && Dense[index] == value;
+        }
+
+        // returns false if value was already there
+        inline bool Insert(unsigned value)
+        {
+            if(Contains(value))
+            {
+                return false;
+            }
+            Dense[Size] = value;
+            Sparse[value] = Size++;
+            return true;
+        }
+
+        inline void Clear()
+        {
+            Size = 0;
+        }
+
+        inline bool Empty() const
+        {
+            return !Size;
+        }
+
+        inline const_iterator begin() const
+        {
+            return Dense.begin();
+        }
+
+        inline const_iterator end() const
+        {
+            return Dense.begin() + Size;
+        }
+
+        inline void swap(TSparseSet& other)
+        {
+            Dense.swap(other.Dense);
+            Sparse.swap(other.Sparse);
+            std::swap(Size, other.Size);
+        }
+    };
+
+    // simulates NFA by tracking the set of active states, takes
+    // O(states + transitions) per character and never allocates after
+    // construction
+    template <class TChar>
+    class TNFAMatcher
+    {
+        typedef typename TNFA<TChar>::TTransitions TTransitions;
+
+        // must outlive this object
+        const TNFA<TChar>& NFA;
+        std::vector<bool> AcceptStates;
+        TSparseSet Current;
+        TSparseSet Next;
+        bool Accept;
+
+        inline void Insert(TSparseSet& set, unsigned state)
+        {
+            if(set.Insert(state))
+            {
+                Accept |= AcceptStates[state];
+            }
+        }
+
+    public:
+        TNFAMatcher(const TNFA<TChar>& nfa)
+            : NFA(nfa)
+            , AcceptStates(nfa.StatesCount())
+            , Current(nfa.StatesCount())
+            , Next(nfa.StatesCount())
+            , Accept(false)
+        {
+            for(typename TNFA<TChar>::TAcceptStates::const_iterator state =
+                nfa.AcceptStates.begin(), end = nfa.AcceptStates.end();
+                state != end; ++state)
+            {
+                AcceptStates[*state] = true;
+            }
+            Reset();
+        }
+
+        inline void Reset()
+        {
+            Current.Clear();
+            Accept = false;
+            Insert(Current, 0);
+        }
+
+        // restart adds start state after the step, which makes every
+        // position a possible match start
+        void Step(TChar character, bool restart = false)
+        {
+            Next.Clear();
+            Accept = false;
+            for(TSparseSet::const_iterator state = Current.begin(),
+                end = Current.end(); state != end; ++state)
+            {
+                // ranges are ordered by their first characters
+                for(typename TTransitions::const_iterator transition =
+                    NFA.Begin(*state), end = NFA.End(*state);
+                    transition != end && !(character < transition->First);
+                    ++transition)
+                {
+                    if(!(transition->Last < character))
+                    {
+                        Insert(Next, transition->Target);
+                    }
+                }
+            }
+            if(restart)
+            {
+                Insert(Next, 0);
+            }
+            Current.swap(Next);
+        }
+
+        // true if input consumed since Reset() is accepted
+        inline bool IsAccept() const
+        {
+            return Accept;
+        }
+
+        // true if no continuation can be accepted
+        inline bool IsDead() const
+        {
+            return Current.Empty();
+        }
+
+        // returns true if the whole [begin, end) range is accepted
+        template <class TIterator>
+        bool Match(TIterator begin, TIterator end)
+        {
+            Reset();
+            for(; begin != end && !IsDead(); ++begin)
+            {
+                Step(*begin);
+            }
+            return IsAccept();
+        }
+
+        // looks for a substring accepted by automaton, on success sets
+        // matchEnd to the end of the earliest ending match
+        template <class TIterator>
+        bool Search(TIterator begin, TIterator end, TIterator& matchEnd)
+        {
+            Reset();
+            while(!IsAccept())
+            {
+                if(begin == end)
+                {
+                    return false;
+                }
+                Step(*begin, true);
+                ++begin;
+            }
+            matchEnd = begin;
+            return true;
+        }
+    };
+}
+
+#endif
+
@@ -0,0 +1,281 @@
+#ifndef __PARALLELMATCHER_HPP_2026_10_17__
+#define __PARALLELMATCHER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include <pthread.h>
+
+namespace NReinventedWheels
+{
+    // runs DFA over one chunk of a buffer without knowing the state the
+    // previous chunks end in: the chunk is speculatively scanned from
+    // every state at once, and since paths of a DFA quickly converge,
+    // runs that reach the same state are merged and continue as one
+    template <class TAutomaton, class TIterator>
+    class TChunkScanner
+    {
+        typedef typename std::iterator_traits<TIterator>::difference_type
+            TDifference;
+
+        // short blocks first, so merging starts before many runs are done
+        enum
+        {
+            FirstBlock = 16,
+            MaxBlock = 1 << 16
+        };
+
+        const TAutomaton* DFA;
+        unsigned StatesCount;
+        TIterator Begin;
+        TIterator End;
+        bool Search;
+        bool Speculative;
+
+        static void* Run(void* scanner)
+        {
+            static_cast<TChunkScanner*>(scanner)->Scan();
+            return 0;
+        }
+
+    public:
+        static const std::size_t NoAccept = static_cast<std::size_t>(-1);
+
+        // for every state the chunk may start in, the state it ends in
+        // and, when searching, the offset just past the first accepting
+        // position, runs are stopped there
+        std::vector<unsigned> EndStates;
+        std::vector<std::size_t> AcceptOffsets;
+
+        // if not speculative, the chunk is scanned from the start state
+        // only, which is the case for the first chunk
+        inline TChunkScanner(const TAutomaton& dfa, unsigned statesCount,
+            TIterator begin, TIterator end, bool search, bool speculative)
+            : DFA(&dfa)
+            , StatesCount(statesCount)
+            , Begin(begin)
+            , End(end)
+            , Search(search)
+            , Speculative(speculative)
+        {
+        }
+
+        inline std::size_t Size() const
+        {
+            return std::distance(Begin, End);
+        }
+
+        void Scan()
+        {
+            const unsigned NoRun = static_cast<unsigned>(-1);
+            // origin states are the ones chunk may start in, each of them
+            // is followed by some run until the run accepts
+            std::vector<unsigned> origins;
+            if(Speculative)
+            {
+                for(unsigned state = 0; state < StatesCount; ++state)
+                {
+                    origins.push_back(state);
+                }
+            }
+            else
+            {
+                origins.push_back(TAutomaton::StartState);
+            }
+            EndStates.assign(StatesCount, TAutomaton::DeadState);
+            AcceptOffsets.assign(StatesCount, NoAccept);
+            std::vector<unsigned> runOf(origins.size());
+            std::vector<unsigned> states(origins);
+            for(unsigned origin = 0; origin < origins.size(); ++origin)
+            {
+                runOf[origin] = origin;
+            }
+
+            std::vector<std::size_t> accepts;
+            std::vector<unsigned> merged(states.size());
+            std::vector<unsigned> runByState(StatesCount, NoRun);
+            std::size_t offset = 0;
+            const std::size_t size = std::distance(Begin, End);
+            for(std::size_t block = FirstBlock; offset != size;
+                block = std::min<std::size_t>(block * 2, MaxBlock))
+            {
+                const std::size_t length = std::min(block, size - offset);
+                const TIterator blockBegin = Begin
+                    + static_cast<TDifference>(offset);
+                const TIterator blockEnd = blockBegin
+                    + static_cast<TDifference>(length);
+                accepts.assign(states.size(), NoAccept);
+                for(unsigned run = 0; run < states.size(); ++run)
+                {
+                    unsigned state = states[run];
+                    if(state == TAutomaton::DeadState)
+                    {
+                        continue;
+                    }
+                    for(TIterator pos = blockBegin; pos != blockEnd;)
+                    {
+                        state = DFA->Next(state, *pos);
+                        ++pos;
+                        if(Search && DFA->IsAccept(state))
+                        {
+                            accepts[run] = offset + std::distance(
+                                blockBegin, pos);
+                            break;
+                        }
+                    }
+                    states[run] = state;
+                }
+                offset += length;
+
+                // accepted runs are done, the rest are merged by state
+                merged.assign(states.size(), NoRun);
+                unsigned runs = 0;
+                for(unsigned run = 0; run < states.size(); ++run)
+                {
+                    if(accepts[run] != NoAccept)
+                    {
+                        continue;
+                    }
+                    unsigned& target = runByState[states[run]];
+                    if(target == NoRun)
+                    {
+                        target = runs;
+                        states[runs++] = states[run];
+                    }
+                    merged[run] = target;
+                }
+                for(unsigned run = 0; run < runs; ++run)
+                {
+                    runByState[states[run]] = NoRun;
+                }
+                states.resize(runs);
+
+                unsigned alive = 0;
+                for(unsigned i = 0; i < origins.size(); ++i)
+                {
+                    const unsigned run = runOf[i];
+                    if(merged[run] == NoRun)
+                    {
+                        AcceptOffsets[origins[i]] = accepts[run];
+                        continue;
+                    }
+                    origins[alive] = origins[i];
+                    runOf[alive++] = merged[run];
+                }
+                origins.resize(alive);
+                runOf.resize(alive);
+                if(origins.empty())
+                {
+                    break;
+                }
+            }
+            for(unsigned i = 0; i < origins.size(); ++i)
+            {
+                EndStates[origins[i]] = states[runOf[i]];
+            }
+        }
+
+        // scans every chunk in its own thread, scanners are scanned in the
+        // calling thread if threads can not be created
+        static void ScanAll(std::vector<TChunkScanner>& scanners)
+        {
+            std::vector<pthread_t> threads(scanners.size());
+            std::vector<bool> started(scanners.size());
+            for(unsigned i = 1; i < scanners.size(); ++i)
+            {
+                started[i] = !pthread_create(&threads[i], 0, &Run,
+                    &scanners[i]);
+            }
+            scanners.front().Scan();
+            for(unsigned i = 1; i < scanners.size(); ++i)
+            {
+                if(started[i])
+                {
+                    pthread_join(threads[i], 0);
+                }
+                else
+                {
+                    scanners[i].Scan();
+                }
+            }
+        }
+
+        // splits [begin, end) into chunks, the first one is not speculative
+        static void Split(const TAutomaton& dfa, unsigned statesCount,
+            TIterator begin, TIterator end, bool search, unsigned chunks,
+            std::vector<TChunkScanner>& scanners)
+        {
+            const std::size_t size = std::distance(begin, end);
+            chunks = std::max(1u, std::min<unsigned>(chunks,
+                size / MaxBlock + 1));
+            for(unsigned i = 0; i < chunks; ++i)
+            {
+                scanners.push_back(TChunkScanner(dfa, statesCount,
+                    begin + static_cast<TDifference>(size * i / chunks),
+                    begin + static_cast<TDifference>(size * (i + 1)
+                        / chunks), search, i != 0));
+            }
+        }
+    };
+
+    template <class TAutomaton, class TIterator>
+    const std::size_t TChunkScanner<TAutomaton, TIterator>::NoAccept;
+
+    // the same as MatchDFA, but the range is split between threads, which
+    // is worth it for large inputs only
+    template <class TAutomaton, class TIterator>
+    bool ParallelMatchDFA(const TAutomaton& dfa, unsigned statesCount,
+        TIterator begin, TIterator end, unsigned threads)
+    {
+        typedef TChunkScanner<TAutomaton, TIterator> TScanner;
+        std::vector<TScanner> scanners;
+        TScanner::Split(dfa, statesCount, begin, end, false, threads,
+            scanners);
+        TScanner::ScanAll(scanners);
+        // chunk results are composed in order
+        unsigned state = TAutomaton::StartState;
+        for(unsigned i = 0; i < scanners.size(); ++i)
+        {
+            state = scanners[i].EndStates[state];
+        }
+        return dfa.IsAccept(state);
+    }
+
+    // the same as SearchDFA, but the range is split between threads
+    template <class TAutomaton, class TIterator>
+    bool ParallelSearchDFA(const TAutomaton& dfa, unsigned statesCount,
+        TIterator begin, TIterator end, TIterator& matchEnd,
+        unsigned threads)
+    {
+        typedef TChunkScanner<TAutomaton, TIterator> TScanner;
+        if(dfa.IsAccept(TAutomaton::StartState))
+        {
+            matchEnd = begin;
+            return true;
+        }
+        std::vector<TScanner> scanners;
+        TScanner::Split(dfa, statesCount, begin, end, true, threads,
+            scanners);
+        TScanner::ScanAll(scanners);
+        unsigned state = TAutomaton::StartState;
+        std::size_t offset = 0;
+        for(unsigned i = 0; i < scanners.size(); ++i)
+        {
+            const std::size_t accept = scanners[i].AcceptOffsets[state];
+            if(accept != TScanner::NoAccept)
+            {
+                matchEnd = begin + static_cast<typename
+                    std::iterator_traits<TIterator>::difference_type>(
+                        offset + accept);
+                return true;
+            }
+            offset += scanners[i].Size();
+            state = scanners[i].EndStates[state];
+        }
+        return false;
+    }
+}
+
+#endif
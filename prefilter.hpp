@@ -0,0 +1,384 @@
+#ifndef __PREFILTER_HPP_2026_10_17__
+#define __PREFILTER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    // finds a literal which is a substring of every string matched by tree
+    template <class TChar>
+    class TLiteralAnalyzer
+    {
+        typedef std::basic_string<TChar> TString;
+
+        // long literals are truncated, so concatenation chains are not
+        // quadratic
+        enum
+        {
+            MaxLength = 64
+        };
+
+        struct TInfo
+        {
+            // node matches Exact string only
+            bool IsExact;
+            TString Exact;
+            // every match starts with Prefix, ends with Suffix and contains
+            // Required
+            TString Prefix;
+            TString Suffix;
+            TString Required;
+        };
+
+        static inline const TString& Better(const TString& first,
+            const TString& second)
+        {
+            return second.size() > first.size() ? second : first;
+        }
+
+        static void SetExact(TInfo& info, const TString& exact)
+        {
+            if(exact.size() > MaxLength)
+            {
+                info.IsExact = false;
+                info.Prefix = exact.substr(0, MaxLength);
+                info.Suffix = exact.substr(exact.size() - MaxLength);
+                info.Required = info.Prefix;
+            }
+            else
+            {
+                info.IsExact = true;
+                info.Exact = exact;
+                info.Prefix = info.Suffix = info.Required = exact;
+            }
+        }
+
+        static void Concatenate(TInfo& result, const TInfo& left,
+            const TInfo& right)
+        {
+            if(left.IsExact && right.IsExact)
+            {
+                SetExact(result, left.Exact + right.Exact);
+                return;
+            }
+            result.IsExact = false;
+            result.Prefix = left.IsExact ? left.Exact + right.Prefix
+                : left.Prefix;
+            result.Prefix.resize(std::min<typename TString::size_type>(
+                result.Prefix.size(), MaxLength));
+            result.Suffix = right.IsExact ? left.Suffix + right.Exact
+                : right.Suffix;
+            if(result.Suffix.size() > MaxLength)
+            {
+                result.Suffix.erase(0, result.Suffix.size() - MaxLength);
+            }
+            TString middle = left.Suffix + right.Prefix;
+            middle.resize(std::min<typename TString::size_type>(
+                middle.size(), MaxLength));
+            result.Required = Better(Better(left.Required, right.Required),
+                Better(middle, Better(result.Prefix, result.Suffix)));
+        }
+
+        static void Alternate(TInfo& result, const TInfo& left,
+            const TInfo& right)
+        {
+            if(left.IsExact && right.IsExact && left.Exact == right.Exact)
+            {
+                result = left;
+                return;
+            }
+            result.IsExact = false;
+            result.Prefix.assign(left.Prefix.begin(), std::mismatch(
+                left.Prefix.begin(), left.Prefix.begin()
+                    + std::min(left.Prefix.size(), right.Prefix.size()),
+                right.Prefix.begin()).first);
+            typename TString::size_type common = 0;
+            while(common < left.Suffix.size() && common < right.Suffix.size()
+                && left.Suffix[left.Suffix.size() - common - 1]
+                == right.Suffix[right.Suffix.size() - common - 1])
+            {
+                ++common;
+            }
+            result.Suffix = left.Suffix.substr(left.Suffix.size() - common);
+            result.Required = left.Required == right.Required
+                ? left.Required : Better(result.Prefix, result.Suffix);
+        }
+
+        static void Repeat(TInfo& result, const TInfo& info,
+            const TRepetition* repetition)
+        {
+            if(!repetition->Min)
+            {
+                // matches empty string
+                result.IsExact = false;
+            }
+            else if(info.IsExact && repetition->Min == repetition->Max)
+            {
+                // copies past MaxLength change neither prefix nor suffix
+                TString exact;
+                for(unsigned i = 0; i < repetition->Min
+                    && exact.size() <= MaxLength; ++i)
+                {
+                    exact += info.Exact;
+                }
+                SetExact(result, exact);
+            }
+            else
+            {
+                result = info;
+                result.IsExact = false;
+            }
+        }
+
+    public:
+        // returns empty string if there is no required literal
+        static TString GetRequiredLiteral(const INode* root)
+        {
+            // post-order traversal, second element is true when children
+            // are already processed and their infos are on the top of infos
+            std::vector<std::pair<const INode*, bool> > stack;
+            std::vector<TInfo> infos;
+            stack.push_back(std::make_pair(root, false));
+            while(!stack.empty())
+            {
+                const INode* node = stack.back().first;
+                const bool visited = stack.back().second;
+                stack.pop_back();
+                if(node->GetNodeType() == TNodeType::Token)
+                {
+                    // class matches a single unknown character
+                    infos.push_back(TInfo());
+                    const TTokenType::TType type =
+                        static_cast<const IToken*>(node)->GetTokenType();
+                    if(type == TTokenType::Character)
+                    {
+                        SetExact(infos.back(), TString(1, static_cast<
+                            const TCharacter<TChar>*>(node)->Character));
+                    }
+                    else if(type == TTokenType::Empty)
+                    {
+                        SetExact(infos.back(), TString());
+                    }
+                    continue;
+                }
+
+                const IOperation* operation =
+                    static_cast<const IOperation*>(node);
+                if(!visited)
+                {
+                    stack.push_back(std::make_pair(node, true));
+                    for(int i = 1; i >= 0; --i)
+                    {
+                        if(operation->Children[i])
+                        {
+                            stack.push_back(std::make_pair(
+                                operation->Children[i], false));
+                        }
+                    }
+                    continue;
+                }
+
+                TInfo result;
+                switch(operation->GetOperationType())
+                {
+                    case TOperationType::Concatenation:
+                        Concatenate(result, infos[infos.size() - 2],
+                            infos.back());
+                        infos.pop_back();
+                        break;
+
+                    case TOperationType::Alternation:
+                        Alternate(result, infos[infos.size() - 2],
+                            infos.back());
+                        infos.pop_back();
+                        break;
+
+                    case TOperationType::Closure:
+                        // matches empty string
+                        result.IsExact = false;
+                        break;
+
+                    case TOperationType::Repetition:
+                        Repeat(result, infos.back(),
+                            static_cast<const TRepetition*>(operation));
+                        break;
+
+                    case TOperationType::Capture:
+                        result = infos.back();
+                        break;
+
+                    default:
+                        throw std::logic_error("unknown operation type");
+                }
+                infos.back() = result;
+            }
+            return infos.back().Required;
+        }
+    };
+
+    // ranks bytes by their typical frequency in text, the lower the rarer
+    inline unsigned GetByteRank(unsigned char byte)
+    {
+        static const char letters[] = "etaoinshrdlcumwfgypbvkjxqz";
+        if(byte == ' ')
+        {
+            return 255;
+        }
+        if(byte >= 'a' && byte <= 'z')
+        {
+            return 254 - (std::strchr(letters, byte) - letters);
+        }
+        if(byte >= '0' && byte <= '9')
+        {
+            return 200;
+        }
+        if(byte >= 'A' && byte <= 'Z')
+        {
+            return 180 - (std::strchr(letters, byte - 'A' + 'a') - letters);
+        }
+        if(byte >= '!' && byte <= '~')
+        {
+            return 150;
+        }
+        return byte == '\t' || byte == '\n' ? 190 : 0;
+    }
+
+    // skips input which can not contain a match
+    struct IPrefilter
+    {
+        virtual inline ~IPrefilter()
+        {
+        }
+
+        // returns the start of the first occurrence of what prefilter looks
+        // for or end
+        virtual const char* Find(const char* begin, const char* end)
+            const = 0;
+    };
+
+    // finds occurrences of a byte literal, checks two of its rarest bytes
+    // 16 or 32 positions at a time with SSE2 or AVX2 and verifies the whole
+    // literal at each candidate
+    class TPrefilter: public IPrefilter
+    {
+        std::string Literal;
+        // positions of the two rarest bytes in literal
+        std::string::size_type First;
+        std::string::size_type Second;
+
+        inline bool Verify(const char* begin) const
+        {
+            return !std::memcmp(begin, Literal.data(), Literal.size());
+        }
+
+    public:
+        // literal must not be empty
+        TPrefilter(const std::string& literal)
+            : Literal(literal)
+            , First(0)
+            , Second(0)
+        {
+            for(std::string::size_type i = 1; i < Literal.size(); ++i)
+            {
+                const unsigned rank = GetByteRank(Literal[i]);
+                if(rank < GetByteRank(Literal[First]))
+                {
+                    Second = First;
+                    First = i;
+                }
+                else if(Second == First
+                    || rank < GetByteRank(Literal[Second]))
+                {
+                    Second = i;
+                }
+            }
+        }
+
+        inline const std::string& GetLiteral() const
+        {
+            return Literal;
+        }
+
+        // returns the start of the first literal occurrence or end
+        virtual const char* Find(const char* begin, const char* end) const
+        {
+            if(static_cast<std::string::size_type>(end - begin)
+                < Literal.size())
+            {
+                return end;
+            }
+            // last possible literal start
+            const char* last = end - Literal.size();
+            const char* pos = begin;
+#if defined(__AVX2__)
+            const __m256i first = _mm256_set1_epi8(Literal[First]);
+            const __m256i second = _mm256_set1_epi8(Literal[Second]);
+            for(; last - pos >= 32; pos += 32)
+            {
+                unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+                    _mm256_cmpeq_epi8(first, _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(pos + First))),
+                    _mm256_cmpeq_epi8(second, _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(pos + Second)))));
+                for(; mask; mask &= mask - 1)
+                {
+                    const char* candidate = pos + __builtin_ctz(mask);
+                    if(Verify(candidate))
+                    {
+                        return candidate;
+                    }
+                }
+            }
+#elif defined(__SSE2__)
+            const __m128i first = _mm_set1_epi8(Literal[First]);
+            const __m128i second = _mm_set1_epi8(Literal[Second]);
+            for(; last - pos >= 16; pos += 16)
+            {
+                unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(first, _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(pos + First))),
+                    _mm_cmpeq_epi8(second, _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(pos + Second)))));
+                for(; mask; mask &= mask - 1)
+                {
+                    const char* candidate = pos + __builtin_ctz(mask);
+                    if(Verify(candidate))
+                    {
+                        return candidate;
+                    }
+                }
+            }
+#endif
+            // tail or no vector instructions
+            while(pos <= last)
+            {
+                const char* found = static_cast<const char*>(std::memchr(
+                    pos + First, Literal[First], last - pos + 1));
+                if(!found)
+                {
+                    break;
+                }
+                pos = found - First;
+                if(Verify(pos))
+                {
+                    return pos;
+                }
+                ++pos;
+            }
+            return end;
+        }
+    };
+}
+
+#endif
+
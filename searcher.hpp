@@ -0,0 +1,229 @@
+#ifndef __SEARCHER_HPP_2026_10_17__
+#define __SEARCHER_HPP_2026_10_17__
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "alphabetgenerator.hpp"
+#include "fsm.hpp"
+#include "lazydfa.hpp"
+#include "nfagenerator.hpp"
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    // returns tree matching reversed strings of the original one, its
+    // operations are placed into arena and its tokens are shared with the
+    // original tree, so it is valid while both the arena and the original
+    // tree live
+    // captures are dropped, since they do not change matched strings
+    inline const INode* ReverseTree(const INode* root, TNodeArena& arena)
+    {
+        // post-order traversal, second element is true when children are
+        // already reversed and their trees are on the top of results
+        std::vector<std::pair<const INode*, bool> > stack;
+        std::vector<const INode*> results;
+        stack.push_back(std::make_pair(root, false));
+        while(!stack.empty())
+        {
+            const INode* node = stack.back().first;
+            const bool visited = stack.back().second;
+            stack.pop_back();
+            if(node->GetNodeType() == TNodeType::Token)
+            {
+                results.push_back(node);
+                continue;
+            }
+
+            const IOperation* operation =
+                static_cast<const IOperation*>(node);
+            if(!visited)
+            {
+                stack.push_back(std::make_pair(node, true));
+                for(int i = 1; i >= 0; --i)
+                {
+                    if(operation->Children[i])
+                    {
+                        stack.push_back(std::make_pair(
+                            operation->Children[i], false));
+                    }
+                }
+                continue;
+            }
+
+            switch(operation->GetOperationType())
+            {
+                case TOperationType::Concatenation:
+                    results[results.size() - 2] = new (arena)
+                        TConcatenation(results.back(),
+                            results[results.size() - 2]);
+                    results.pop_back();
+                    break;
+
+                case TOperationType::Alternation:
+                    results[results.size() - 2] = new (arena)
+                        TAlternation(results[results.size() - 2],
+                            results.back());
+                    results.pop_back();
+                    break;
+
+                case TOperationType::Closure:
+                    results.back() = new (arena) TClosure(results.back());
+                    break;
+
+                case TOperationType::Repetition:
+                {
+                    const TRepetition* repetition =
+                        static_cast<const TRepetition*>(operation);
+                    results.back() = new (arena) TRepetition(results.back(),
+                        repetition->Min, repetition->Max);
+                    break;
+                }
+
+                case TOperationType::Capture:
+                    break;
+
+                default:
+                    throw std::logic_error("unknown operation type");
+            }
+        }
+        return results.back();
+    }
+
+    // finds leftmost-longest matches, the ones POSIX regexec and grep
+    // report, each of them in two passes:
+    // forward pass runs leftmost-longest DFA, the last accept state it
+    // meets ends the match and it stops at the dead state, then reversed
+    // pattern is run backwards from the match end, and the last accept
+    // state it meets starts the match, since no match starts earlier
+    // both automata are lazy, so only NFAs are built up front and memory
+    // is bounded by cache capacity, however many states the pattern needs
+    // forward pass goes on after the match end while some earlier started
+    // match may still get longer, and the next search scans these
+    // characters again, so SearchAll takes O(n * matches) time in the
+    // worst case, e.g. b[^z]*z|c on bcbc...bc scans to the input end for
+    // every c, while it is linear if matches can not be extended far
+    // the input must be scanned by bidirectional iterators
+    // keeps automata caches, so every thread needs its own instance
+    template <class TChar>
+    class TMatchSearcher
+    {
+        // must be constructed before automata, which refer to them
+        const TNFA<TChar> ForwardNFA;
+        const TNFA<TChar> ReverseNFA;
+        TLazyDFA<TChar> Forward;
+        TLazyDFA<TChar> Reverse;
+
+        static TNFA<TChar> CreateReverseNFA(const INode* root)
+        {
+            TNodeArena arena;
+            return TNFAGenerator<TChar>::CreateNFA(ReverseTree(root, arena));
+        }
+
+        TMatchSearcher(const TMatchSearcher&);
+        TMatchSearcher& operator = (const TMatchSearcher&);
+
+    public:
+        // (begin, end) offsets of a match
+        typedef std::vector<std::pair<std::size_t, std::size_t> > TMatches;
+
+        // capacity is the number of states cached by each automaton
+        // reversed tree has the same characters, so the alphabet fits both
+        explicit TMatchSearcher(const INode* root, unsigned capacity = 4096)
+            : ForwardNFA(TNFAGenerator<TChar>::CreateNFA(root))
+            , ReverseNFA(CreateReverseNFA(root))
+            , Forward(ForwardNFA,
+                TAlphabetGenerator<TChar>::CreateAlphabet(root), capacity,
+                true)
+            , Reverse(ReverseNFA,
+                TAlphabetGenerator<TChar>::CreateAlphabet(root), capacity)
+        {
+        }
+
+        inline const TLazyDFA<TChar>& GetForwardDFA() const
+        {
+            return Forward;
+        }
+
+        inline const TLazyDFA<TChar>& GetReverseDFA() const
+        {
+            return Reverse;
+        }
+
+        // on success sets [matchBegin, matchEnd) to the leftmost-longest
+        // match within [begin, end)
+        template <class TIterator>
+        bool Search(TIterator begin, TIterator end, TIterator& matchBegin,
+            TIterator& matchEnd)
+        {
+            unsigned state = TLazyDFA<TChar>::StartState;
+            bool found = Forward.IsAccept(state);
+            TIterator last = begin;
+            for(TIterator current = begin; current != end
+                && state != TLazyDFA<TChar>::DeadState;)
+            {
+                state = Forward.Next(state, *current);
+                ++current;
+                if(Forward.IsAccept(state))
+                {
+                    found = true;
+                    last = current;
+                }
+            }
+            if(!found)
+            {
+                return false;
+            }
+
+            state = TLazyDFA<TChar>::StartState;
+            TIterator first = last;
+            for(TIterator current = last; current != begin
+                && state != TLazyDFA<TChar>::DeadState;)
+            {
+                --current;
+                state = Reverse.Next(state, *current);
+                if(Reverse.IsAccept(state))
+                {
+                    first = current;
+                }
+            }
+            matchBegin = first;
+            matchEnd = last;
+            return true;
+        }
+
+        // appends offsets of non-overlapping matches from left to right,
+        // every search continues from the end of the previous match, or
+        // the next character after an empty match
+        template <class TIterator>
+        void SearchAll(TIterator begin, TIterator end, TMatches& matches)
+        {
+            TIterator from = begin;
+            std::size_t offset = 0;
+            TIterator matchBegin;
+            TIterator matchEnd;
+            while(Search(from, end, matchBegin, matchEnd))
+            {
+                const std::size_t first =
+                    offset + std::distance(from, matchBegin);
+                offset = first + std::distance(matchBegin, matchEnd);
+                matches.push_back(std::make_pair(first, offset));
+                from = matchEnd;
+                if(matchBegin == matchEnd)
+                {
+                    if(from == end)
+                    {
+                        break;
+                    }
+                    ++from;
+                    ++offset;
+                }
+            }
+        }
+    };
+}
+
+#endif
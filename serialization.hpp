@@ -0,0 +1,467 @@
+#ifndef __SERIALIZATION_HPP_2026_10_17__
+#define __SERIALIZATION_HPP_2026_10_17__
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <stdint.h>
+
+#include "fsm.hpp"
+
+namespace NReinventedWheels
+{
+    // compiled automata are stored as a header followed by sections of
+    // native 32 bit words, sections are addressed by offsets from the image
+    // start, so the image can be mapped anywhere and used in place
+    struct TImageFormat
+    {
+        // automata store state numbers as unsigned
+        typedef char TWordRequired[sizeof(unsigned) == sizeof(uint32_t)
+            ? 1 : -1];
+
+        enum
+        {
+            Version = 2,
+            // written in native order, detects images from other machines
+            ByteOrderMark = 0x01020304,
+            // sections start at cache line boundary
+            Alignment = 64
+        };
+
+        static inline std::size_t Align(std::size_t offset)
+        {
+            return (offset + Alignment - 1) & ~static_cast<std::size_t>(
+                Alignment - 1);
+        }
+
+        static void WriteSection(std::ostream& output, std::size_t& offset,
+            const void* data, std::size_t size)
+        {
+            static const char padding[Alignment] = {};
+            const std::size_t aligned = Align(offset);
+            output.write(padding, aligned - offset);
+            output.write(static_cast<const char*>(data), size);
+            offset = aligned + size;
+        }
+
+        // throws if [offset, offset + count words) is not inside the image,
+        // count is 64 bit, so counts computed from header fields can not
+        // wrap around
+        static void CheckSection(std::size_t size, uint32_t offset,
+            uint64_t count)
+        {
+            if(offset % sizeof(uint32_t) || offset > size
+                || (size - offset) / sizeof(uint32_t) < count)
+            {
+                throw std::logic_error("automaton image is truncated");
+            }
+        }
+    };
+
+    struct TDFAImageHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t ByteOrderMark;
+        // total image size in bytes
+        uint32_t Size;
+        uint32_t StatesCount;
+        uint32_t ClassesCount;
+        uint32_t PatternsCount;
+        // sections offsets: StatesCount rows of ClassesCount targets,
+        // accept states bitmap, StatesCount + 1 pattern offsets and
+        // PatternsCount accepted patterns
+        uint32_t Transitions;
+        uint32_t AcceptStates;
+        uint32_t PatternOffsets;
+        uint32_t AcceptPatterns;
+        unsigned char Classes[TAlphabet::Size];
+    };
+
+    // writes dfa image, image layout does not depend on TChar
+    template <class TChar>
+    void SaveDFA(const TDFA<TChar>& dfa, std::ostream& output)
+    {
+        TDFAImageHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.Magic, "RWDFA", 5);
+        header.Version = TImageFormat::Version;
+        header.ByteOrderMark = TImageFormat::ByteOrderMark;
+        header.StatesCount = dfa.StatesCount;
+        header.ClassesCount = dfa.Alphabet.ClassesCount;
+        header.PatternsCount = dfa.AcceptPatterns.size();
+        std::memcpy(header.Classes, dfa.Alphabet.Classes,
+            sizeof(header.Classes));
+
+        const std::size_t sizes[] = {
+            dfa.Transitions.size() * sizeof(uint32_t),
+            dfa.AcceptStates.size() * sizeof(uint32_t),
+            dfa.PatternOffsets.size() * sizeof(uint32_t),
+            dfa.AcceptPatterns.size() * sizeof(uint32_t)};
+        uint32_t* offsets[] = {&header.Transitions, &header.AcceptStates,
+            &header.PatternOffsets, &header.AcceptPatterns};
+        std::size_t offset = sizeof(header);
+        for(unsigned i = 0; i < 4; ++i)
+        {
+            offset = TImageFormat::Align(offset);
+            *offsets[i] = offset;
+            offset += sizes[i];
+        }
+        if(offset > static_cast<uint32_t>(-1))
+        {
+            throw std::logic_error("automaton is too large to be saved");
+        }
+        header.Size = offset;
+
+        offset = 0;
+        TImageFormat::WriteSection(output, offset, &header, sizeof(header));
+        const unsigned* sections[] = {&dfa.Transitions[0],
+            &dfa.AcceptStates[0],
+            dfa.PatternOffsets.empty() ? 0 : &dfa.PatternOffsets[0],
+            dfa.AcceptPatterns.empty() ? 0 : &dfa.AcceptPatterns[0]};
+        for(unsigned i = 0; i < 4; ++i)
+        {
+            TImageFormat::WriteSection(output, offset, sections[i],
+                sizes[i]);
+        }
+    }
+
+    // dfa stored in an image, nothing is copied, so the image memory must
+    // outlive the view, constructor checks the header, byte classes and
+    // pattern offsets, while transition targets are trusted unless
+    // Validate is called
+    // provides the same interface as TDFA, so it works with MatchDFA,
+    // SearchDFA, SearchPatternsDFA and TDFAStepper
+    template <class TChar>
+    class TDFAView
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        const TDFAImageHeader* Header;
+        const uint32_t* Transitions;
+        const uint32_t* AcceptStates;
+        const uint32_t* PatternOffsets;
+        const uint32_t* AcceptPatterns;
+
+    public:
+        enum
+        {
+            DeadState = TDFA<TChar>::DeadState,
+            StartState = TDFA<TChar>::StartState
+        };
+
+        typedef const uint32_t* TPatternIterator;
+
+        // image must be aligned to 4 bytes at least, mmap result is
+        TDFAView(const void* image, std::size_t size)
+            : Header(static_cast<const TDFAImageHeader*>(image))
+        {
+            if(size < sizeof(Header->Magic)
+                || std::memcmp(Header->Magic, "RWDFA", 6))
+            {
+                throw std::logic_error("not an automaton image");
+            }
+            if(size < sizeof(TDFAImageHeader))
+            {
+                throw std::logic_error("automaton image is truncated");
+            }
+            if(Header->ByteOrderMark != TImageFormat::ByteOrderMark
+                || Header->Version != TImageFormat::Version)
+            {
+                throw std::logic_error("unsupported automaton image version");
+            }
+            // dead and start states are always present
+            if(Header->Size > size
+                || Header->StatesCount <= TDFA<TChar>::StartState
+                || !Header->ClassesCount)
+            {
+                throw std::logic_error("automaton image is truncated");
+            }
+            const uint64_t states = Header->StatesCount;
+            TImageFormat::CheckSection(Header->Size, Header->Transitions,
+                states * Header->ClassesCount);
+            TImageFormat::CheckSection(Header->Size, Header->AcceptStates,
+                (states + sizeof(uint32_t) * CHAR_BIT - 1)
+                / (sizeof(uint32_t) * CHAR_BIT));
+            TImageFormat::CheckSection(Header->Size, Header->PatternOffsets,
+                states + 1);
+            TImageFormat::CheckSection(Header->Size, Header->AcceptPatterns,
+                Header->PatternsCount);
+
+            const char* base = static_cast<const char*>(image);
+            Transitions = reinterpret_cast<const uint32_t*>(
+                base + Header->Transitions);
+            AcceptStates = reinterpret_cast<const uint32_t*>(
+                base + Header->AcceptStates);
+            PatternOffsets = reinterpret_cast<const uint32_t*>(
+                base + Header->PatternOffsets);
+            AcceptPatterns = reinterpret_cast<const uint32_t*>(
+                base + Header->AcceptPatterns);
+            for(unsigned i = 0; i < TAlphabet::Size; ++i)
+            {
+                if(Header->Classes[i] >= Header->ClassesCount)
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+            }
+            for(uint32_t state = 0; state < Header->StatesCount; ++state)
+            {
+                if(PatternOffsets[state] > PatternOffsets[state + 1])
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+            }
+            if(PatternOffsets[states] != Header->PatternsCount)
+            {
+                throw std::logic_error("automaton image is corrupted");
+            }
+        }
+
+        // throws if some transition leads outside of the automaton, takes
+        // one pass over the transition table, so images from untrusted
+        // sources should be checked by it before use
+        void Validate() const
+        {
+            const uint32_t* end = Transitions
+                + Header->StatesCount * Header->ClassesCount;
+            for(const uint32_t* target = Transitions; target != end;
+                ++target)
+            {
+                if(*target >= Header->StatesCount)
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+            }
+        }
+
+        inline unsigned Next(unsigned state, TChar character) const
+        {
+            return Transitions[state * Header->ClassesCount
+                + Header->Classes[static_cast<unsigned char>(character)]];
+        }
+
+        inline bool IsAccept(unsigned state) const
+        {
+            return AcceptStates[state / (sizeof(uint32_t) * CHAR_BIT)]
+                >> (state % (sizeof(uint32_t) * CHAR_BIT)) & 1;
+        }
+
+        inline TPatternIterator PatternsBegin(unsigned state) const
+        {
+            return AcceptPatterns + PatternOffsets[state];
+        }
+
+        inline TPatternIterator PatternsEnd(unsigned state) const
+        {
+            return AcceptPatterns + PatternOffsets[state + 1];
+        }
+
+        inline unsigned StatesCount() const
+        {
+            return Header->StatesCount;
+        }
+
+        inline unsigned ClassesCount() const
+        {
+            return Header->ClassesCount;
+        }
+    };
+
+    struct TNFAImageHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t ByteOrderMark;
+        uint32_t Size;
+        // characters are stored as 32 bit words
+        uint32_t CharacterSize;
+        uint32_t StatesCount;
+        uint32_t TransitionsCount;
+        uint32_t AcceptStatesCount;
+        uint32_t PatternsCount;
+        // sections offsets: StatesCount + 1 transition offsets,
+        // TransitionsCount (first, last, target) triples, accept states,
+        // AcceptStatesCount + 1 pattern offsets and accepted patterns
+        uint32_t Offsets;
+        uint32_t Transitions;
+        uint32_t AcceptStates;
+        uint32_t PatternOffsets;
+        uint32_t AcceptPatterns;
+    };
+
+    // NFA matchers work with TNFA containers, so NFA image is loaded by
+    // copying, which is still much cheaper than construction from patterns
+    template <class TChar>
+    class TNFASerializer
+    {
+        typedef char TCharacterRequired[sizeof(TChar) <= sizeof(uint32_t)
+            ? 1 : -1];
+
+        static inline void LoadSection(const char* base, uint32_t offset,
+            std::size_t count, std::vector<unsigned>& result)
+        {
+            const uint32_t* begin = reinterpret_cast<const uint32_t*>(
+                base + offset);
+            result.assign(begin, begin + count);
+        }
+
+    public:
+        static void Save(const TNFA<TChar>& nfa, std::ostream& output)
+        {
+            TNFAImageHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.Magic, "RWNFA", 5);
+            header.Version = TImageFormat::Version;
+            header.ByteOrderMark = TImageFormat::ByteOrderMark;
+            header.CharacterSize = sizeof(TChar);
+            header.StatesCount = nfa.StatesCount();
+            header.TransitionsCount = nfa.Transitions.size();
+            header.AcceptStatesCount = nfa.AcceptStates.size();
+            header.PatternsCount = nfa.AcceptPatterns.size();
+
+            std::vector<unsigned> transitions;
+            transitions.reserve(nfa.Transitions.size() * 3);
+            for(typename TNFA<TChar>::TTransitions::const_iterator
+                transition = nfa.Transitions.begin(),
+                end = nfa.Transitions.end(); transition != end; ++transition)
+            {
+                transitions.push_back(static_cast<uint32_t>(
+                    transition->First));
+                transitions.push_back(static_cast<uint32_t>(
+                    transition->Last));
+                transitions.push_back(transition->Target);
+            }
+
+            const std::vector<unsigned>* sections[] = {&nfa.Offsets,
+                &transitions, &nfa.AcceptStates, &nfa.PatternOffsets,
+                &nfa.AcceptPatterns};
+            uint32_t* offsets[] = {&header.Offsets, &header.Transitions,
+                &header.AcceptStates, &header.PatternOffsets,
+                &header.AcceptPatterns};
+            std::size_t offset = sizeof(header);
+            for(unsigned i = 0; i < 5; ++i)
+            {
+                offset = TImageFormat::Align(offset);
+                *offsets[i] = offset;
+                offset += sections[i]->size() * sizeof(uint32_t);
+            }
+            if(offset > static_cast<uint32_t>(-1))
+            {
+                throw std::logic_error("automaton is too large to be saved");
+            }
+            header.Size = offset;
+
+            offset = 0;
+            TImageFormat::WriteSection(output, offset, &header,
+                sizeof(header));
+            for(unsigned i = 0; i < 5; ++i)
+            {
+                TImageFormat::WriteSection(output, offset,
+                    sections[i]->empty() ? 0 : &(*sections[i])[0],
+                    sections[i]->size() * sizeof(uint32_t));
+            }
+        }
+
+        // image must be aligned to 4 bytes at least
+        static TNFA<TChar> Load(const void* image, std::size_t size)
+        {
+            const TNFAImageHeader* header =
+                static_cast<const TNFAImageHeader*>(image);
+            if(size < sizeof(header->Magic)
+                || std::memcmp(header->Magic, "RWNFA", 6))
+            {
+                throw std::logic_error("not an automaton image");
+            }
+            if(size < sizeof(TNFAImageHeader))
+            {
+                throw std::logic_error("automaton image is truncated");
+            }
+            if(header->ByteOrderMark != TImageFormat::ByteOrderMark
+                || header->Version != TImageFormat::Version
+                || header->CharacterSize != sizeof(TChar))
+            {
+                throw std::logic_error("unsupported automaton image version");
+            }
+            // start state is always present
+            if(header->Size > size || !header->StatesCount)
+            {
+                throw std::logic_error("automaton image is truncated");
+            }
+            // counts are widened before arithmetic, so they can not wrap
+            // around and pass the checks
+            const uint64_t states = header->StatesCount;
+            const uint64_t acceptStates = header->AcceptStatesCount;
+            TImageFormat::CheckSection(header->Size, header->Offsets,
+                states + 1);
+            TImageFormat::CheckSection(header->Size, header->Transitions,
+                static_cast<uint64_t>(header->TransitionsCount) * 3);
+            TImageFormat::CheckSection(header->Size, header->AcceptStates,
+                acceptStates);
+            TImageFormat::CheckSection(header->Size, header->PatternOffsets,
+                acceptStates + 1);
+            TImageFormat::CheckSection(header->Size, header->AcceptPatterns,
+                header->PatternsCount);
+
+            // sections fit into the image, so their sizes fit into size_t
+            const char* base = static_cast<const char*>(image);
+            TNFA<TChar> result;
+            LoadSection(base, header->Offsets,
+                static_cast<std::size_t>(states + 1), result.Offsets);
+            LoadSection(base, header->AcceptStates,
+                static_cast<std::size_t>(acceptStates), result.AcceptStates);
+            LoadSection(base, header->PatternOffsets,
+                static_cast<std::size_t>(acceptStates + 1),
+                result.PatternOffsets);
+            LoadSection(base, header->AcceptPatterns, header->PatternsCount,
+                result.AcceptPatterns);
+            const uint32_t* transition = reinterpret_cast<const uint32_t*>(
+                base + header->Transitions);
+            result.Transitions.reserve(header->TransitionsCount);
+            for(uint32_t i = 0; i < header->TransitionsCount; ++i)
+            {
+                if(transition[3 * i + 2] >= header->StatesCount)
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+                result.Transitions.push_back(
+                    typename TNFA<TChar>::TTransition(
+                        static_cast<TChar>(transition[3 * i]),
+                        static_cast<TChar>(transition[3 * i + 1]),
+                        transition[3 * i + 2]));
+            }
+            if(result.Offsets.back() != result.Transitions.size()
+                || result.PatternOffsets.back()
+                != result.AcceptPatterns.size())
+            {
+                throw std::logic_error("automaton image is corrupted");
+            }
+            // matchers index by all of these, so they must be ordered and
+            // stay inside of the automaton
+            for(uint32_t state = 0; state < header->StatesCount; ++state)
+            {
+                if(result.Offsets[state] > result.Offsets[state + 1])
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+            }
+            for(uint32_t i = 0; i < header->AcceptStatesCount; ++i)
+            {
+                if(result.AcceptStates[i] >= header->StatesCount
+                    || (i && result.AcceptStates[i - 1]
+                        >= result.AcceptStates[i])
+                    || result.PatternOffsets[i]
+                    > result.PatternOffsets[i + 1])
+                {
+                    throw std::logic_error("automaton image is corrupted");
+                }
+            }
+            return result;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef __STREAMMATCHER_HPP_2026_10_17__
+#define __STREAMMATCHER_HPP_2026_10_17__
+
+#include <iterator>
+
+namespace NReinventedWheels
+{
+    // feeds a stream split into arbitrary chunks to a stepping matcher
+    // (TDFAStepper, TNFAMatcher or TBitParallelMatcher), automaton state is
+    // kept between chunks, so no chunk is copied or scanned twice
+    // reporter is called with absolute stream offset of every match end,
+    // including 0 for the empty match at stream start
+    // in anchored mode matches start at the stream start, in unanchored mode
+    // they can start anywhere, TDFAStepper automaton must be created
+    // unanchored for this
+    template <class TEngine, class TReporter>
+    class TStreamMatcher
+    {
+    public:
+        typedef unsigned long TOffset;
+
+    private:
+        TEngine& Engine;
+        TReporter& Reporter;
+        const bool Unanchored;
+        TOffset Offset;
+        bool Started;
+
+        inline void Start()
+        {
+            Started = true;
+            if(Engine.IsAccept())
+            {
+                Reporter(Offset);
+            }
+        }
+
+    public:
+        inline TStreamMatcher(TEngine& engine, TReporter& reporter,
+            bool unanchored = true)
+            : Engine(engine)
+            , Reporter(reporter)
+            , Unanchored(unanchored)
+            , Offset(0)
+            , Started(false)
+        {
+            Engine.Reset();
+        }
+
+        template <class TIterator>
+        void Feed(TIterator begin, TIterator end)
+        {
+            if(!Started)
+            {
+                Start();
+            }
+            for(; begin != end; ++begin)
+            {
+                if(Engine.IsDead() && !Unanchored)
+                {
+                    // nothing will match until the end of stream
+                    Offset += std::distance(begin, end);
+                    break;
+                }
+                Engine.Step(*begin, Unanchored);
+                ++Offset;
+                if(Engine.IsAccept())
+                {
+                    Reporter(Offset);
+                }
+            }
+        }
+
+        // ends the stream, returns true if the whole stream was accepted in
+        // anchored mode or if it ends with a match in unanchored mode
+        // matcher is ready for the next stream afterwards
+        bool Finish()
+        {
+            if(!Started)
+            {
+                Start();
+            }
+            const bool result = Engine.IsAccept();
+            Engine.Reset();
+            Offset = 0;
+            Started = false;
+            return result;
+        }
+
+        // number of characters fed since the stream start
+        inline TOffset GetOffset() const
+        {
+            return Offset;
+        }
+    };
+}
+
+#endif
+
@@ -0,0 +1,75 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "submatcher.hpp"
+#include "taggednfagenerator.hpp"
+#include "token.hpp"
+using namespace NReinventedWheels;
+
+// expected slots are the ones leftmost-first backtracking engines report
+struct TCase
+{
+    const char* Pattern;
+    const char* Input;
+    // 0 if the input does not match
+    unsigned Groups;
+    std::ptrdiff_t Slots[6];
+};
+
+// optional nodes keep slots of their preferred empty match
+const TCase Cases[] =
+{
+    {"a(?:|b)?(b*)", "ab", 2, {0, 2, 1, 2}},
+    {".*([a-c]()?)", "aaab", 3, {0, 4, 3, 4, 4, 4}},
+    {"([ab]*)?", "", 2, {0, 0, 0, 0}},
+    {"(a|)?b", "b", 2, {0, 1, 0, 0}},
+    {"(a)?(b)?", "b", 3, {0, 1, -1, -1, 0, 1}},
+    {"(a|ab)(c|bcd)", "abcd", 3, {0, 4, 0, 1, 1, 4}},
+    {"(a*)*", "b", 0, {}}
+};
+
+// checks submatches of both engines, returns the number of failures
+int main()
+{
+    int failures = 0;
+    for(unsigned i = 0; i < sizeof(Cases) / sizeof(Cases[0]); ++i)
+    {
+        const TCase& test = Cases[i];
+        TNodePtr root;
+        root.Set(Parse(test.Pattern, test.Pattern + strlen(test.Pattern)));
+        const TTaggedNFA<char> nfa =
+            TTaggedNFAGenerator<char>::CreateNFA(root.Get());
+        const TCaptures expected(test.Slots, test.Slots + test.Groups * 2);
+        const std::string input = test.Input;
+        TSubmatcher<char> submatcher(nfa);
+        TPikeVM<char> pikeVM(nfa);
+        TCaptures results[2];
+        const bool matched[2] = {
+            submatcher.Match(input.begin(), input.end(), results[0]),
+            pikeVM.Match(input.begin(), input.end(), results[1])
+        };
+        for(unsigned engine = 0; engine < 2; ++engine)
+        {
+            if(matched[engine] != (test.Groups != 0)
+                || (matched[engine] && results[engine] != expected))
+            {
+                ++failures;
+                std::cerr << test.Pattern << " on \"" << test.Input
+                    << "\": " << (engine ? "Pike VM" : "submatcher")
+                    << " gives";
+                if(!matched[engine])
+                {
+                    std::cerr << " no match";
+                }
+                for(unsigned slot = 0; matched[engine]
+                    && slot < results[engine].size(); ++slot)
+                {
+                    std::cerr << ' ' << results[engine][slot];
+                }
+                std::cerr << std::endl;
+            }
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,252 @@
+#ifndef __SUBMATCHER_HPP_2026_10_17__
+#define __SUBMATCHER_HPP_2026_10_17__
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "fsm.hpp"
+#include "nfamatcher.hpp"
+
+namespace NReinventedWheels
+{
+    // submatches are returned as slots of TTaggedNFA, offsets from the
+    // input start, groups which did not participate in the match have -1
+    // in both of their slots
+    typedef std::vector<std::ptrdiff_t> TCaptures;
+
+    // simulates tagged NFA keeping a single thread per state, threads are
+    // ordered by priority and a state is kept by the first thread entering
+    // it, so submatches are the ones backtracking would find, apart from
+    // empty loop iterations, which are skipped, but time is
+    // O(transitions * slots) per character and nothing is allocated after
+    // construction
+    template <class TChar>
+    class TPikeVM
+    {
+        // must outlive this object
+        const TTaggedNFA<TChar>& NFA;
+        const unsigned Slots;
+        TSparseSet Current;
+        TSparseSet Next;
+        // slots of threads, state i uses [i * Slots, (i + 1) * Slots)
+        TCaptures CurrentSlots;
+        TCaptures NextSlots;
+
+    public:
+        TPikeVM(const TTaggedNFA<TChar>& nfa)
+            : NFA(nfa)
+            , Slots(nfa.SlotsCount())
+            , Current(nfa.StatesCount())
+            , Next(nfa.StatesCount())
+            , CurrentSlots(nfa.StatesCount() * Slots)
+            , NextSlots(nfa.StatesCount() * Slots)
+        {
+        }
+
+        // returns true if the whole [begin, end) range matches
+        template <class TIterator>
+        bool Match(TIterator begin, TIterator end, TCaptures& captures)
+        {
+            Current.Clear();
+            Current.Insert(0);
+            std::fill(CurrentSlots.begin(), CurrentSlots.begin() + Slots,
+                -1);
+            std::ptrdiff_t offset = 0;
+            for(; begin != end; ++begin, ++offset)
+            {
+                const TChar character = *begin;
+                Next.Clear();
+                for(TSparseSet::const_iterator state = Current.begin(),
+                    end = Current.end(); state != end; ++state)
+                {
+                    const TCaptures::const_iterator slots =
+                        CurrentSlots.begin() + *state * Slots;
+                    for(typename TTaggedNFA<TChar>::TTransitions::
+                        const_iterator transition = NFA.Begin(*state),
+                        end = NFA.End(*state); transition != end;
+                        ++transition)
+                    {
+                        if(!transition->Contains(character)
+                            || !Next.Insert(transition->Target))
+                        {
+                            continue;
+                        }
+                        const TCaptures::iterator target =
+                            NextSlots.begin() + transition->Target * Slots;
+                        std::copy(slots, slots + Slots, target);
+                        for(unsigned tag = transition->TagsBegin;
+                            tag != transition->TagsEnd; ++tag)
+                        {
+                            target[NFA.Tags[tag]] = offset;
+                        }
+                    }
+                }
+                if(Next.Empty())
+                {
+                    return false;
+                }
+                Current.swap(Next);
+                CurrentSlots.swap(NextSlots);
+            }
+
+            for(TSparseSet::const_iterator state = Current.begin(),
+                end = Current.end(); state != end; ++state)
+            {
+                if(NFA.AcceptStates[*state])
+                {
+                    captures.assign(CurrentSlots.begin() + *state * Slots,
+                        CurrentSlots.begin() + (*state + 1) * Slots);
+                    for(unsigned tag = NFA.FinalOffsets[*state];
+                        tag != NFA.FinalOffsets[*state + 1]; ++tag)
+                    {
+                        captures[NFA.Tags[tag]] = offset;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // tagged NFA in which every state has at most one transition for
+    // every character, so there is only one thread and its slots are set
+    // in place, turned into a dense table over byte classes like TDFA
+    template <class TChar>
+    class TOnePassDFA
+    {
+        typedef char TByteCharacterRequired[sizeof(TChar) == 1 ? 1 : -1];
+
+        static const unsigned NoTransition = static_cast<unsigned>(-1);
+
+        // must outlive this object
+        const TTaggedNFA<TChar>* NFA;
+        TAlphabet Alphabet;
+        // index of transition taken from state i by byte class c is
+        // Table[i * Alphabet.ClassesCount + c]
+        std::vector<unsigned> Table;
+
+    public:
+        inline TOnePassDFA()
+            : NFA(0)
+        {
+        }
+
+        // returns false and leaves result unusable if nfa is not one-pass
+        static bool Create(const TTaggedNFA<TChar>& nfa,
+            TOnePassDFA& result)
+        {
+            result.NFA = &nfa;
+            result.Alphabet = TAlphabet();
+            for(typename TTaggedNFA<TChar>::TTransitions::const_iterator
+                transition = nfa.Transitions.begin(),
+                end = nfa.Transitions.end(); transition != end; ++transition)
+            {
+                result.Alphabet.AddRange(transition->First,
+                    transition->Last);
+            }
+            const unsigned classes = result.Alphabet.ClassesCount;
+            result.Table.assign(nfa.StatesCount() * classes, NoTransition);
+            for(unsigned state = 0; state < nfa.StatesCount(); ++state)
+            {
+                unsigned* row = &result.Table[0] + state * classes;
+                for(unsigned transition = nfa.Offsets[state];
+                    transition != nfa.Offsets[state + 1]; ++transition)
+                {
+                    for(unsigned byte = 0; byte < TAlphabet::Size; ++byte)
+                    {
+                        if(!nfa.Transitions[transition].Contains(
+                            static_cast<TChar>(byte)))
+                        {
+                            continue;
+                        }
+                        unsigned& cell = row[result.Alphabet[byte]];
+                        if(cell != NoTransition && cell != transition)
+                        {
+                            return false;
+                        }
+                        cell = transition;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // returns true if the whole [begin, end) range matches
+        template <class TIterator>
+        bool Match(TIterator begin, TIterator end, TCaptures& captures) const
+        {
+            const unsigned classes = Alphabet.ClassesCount;
+            captures.assign(NFA->SlotsCount(), -1);
+            unsigned state = 0;
+            std::ptrdiff_t offset = 0;
+            for(; begin != end; ++begin, ++offset)
+            {
+                const unsigned index = Table[state * classes
+                    + Alphabet[static_cast<unsigned char>(*begin)]];
+                if(index == NoTransition)
+                {
+                    return false;
+                }
+                const typename TTaggedNFA<TChar>::TTransition& transition =
+                    NFA->Transitions[index];
+                for(unsigned tag = transition.TagsBegin;
+                    tag != transition.TagsEnd; ++tag)
+                {
+                    captures[NFA->Tags[tag]] = offset;
+                }
+                state = transition.Target;
+            }
+            if(!NFA->AcceptStates[state])
+            {
+                return false;
+            }
+            for(unsigned tag = NFA->FinalOffsets[state];
+                tag != NFA->FinalOffsets[state + 1]; ++tag)
+            {
+                captures[NFA->Tags[tag]] = offset;
+            }
+            return true;
+        }
+    };
+
+    template <class TChar>
+    const unsigned TOnePassDFA<TChar>::NoTransition;
+
+    // extracts submatches with one-pass automaton when the pattern allows
+    // it and with Pike VM otherwise, both take linear time and never
+    // backtrack
+    // keeps matching state, so every thread needs its own instance
+    template <class TChar>
+    class TSubmatcher
+    {
+        TOnePassDFA<TChar> OnePassDFA;
+        const bool OnePass;
+        TPikeVM<TChar> PikeVM;
+
+    public:
+        // nfa must outlive this object
+        TSubmatcher(const TTaggedNFA<TChar>& nfa)
+            : OnePass(TOnePassDFA<TChar>::Create(nfa, OnePassDFA))
+            , PikeVM(nfa)
+        {
+        }
+
+        inline bool IsOnePass() const
+        {
+            return OnePass;
+        }
+
+        // returns true if the whole [begin, end) range matches, sets
+        // captures on success
+        template <class TIterator>
+        inline bool Match(TIterator begin, TIterator end,
+            TCaptures& captures)
+        {
+            return OnePass ? OnePassDFA.Match(begin, end, captures)
+                : PikeVM.Match(begin, end, captures);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,472 @@
+#ifndef __TAGGEDNFAGENERATOR_HPP_2026_10_17__
+#define __TAGGEDNFAGENERATOR_HPP_2026_10_17__
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "fsm.hpp"
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    // builds position automaton like TNFAGenerator, but keeps transitions
+    // in priority order and marks them with capture slots they set
+    // every position has a list of its continuations in priority order,
+    // which has a hole where the continuation after the node containing
+    // the position goes, so priorities are exact: alternatives are
+    // preferred from left to right, closures and repetitions are greedy
+    // the only difference from backtracking is that loop iterations never
+    // match empty string, such iterations are skipped, while an optional
+    // node keeps its own preferred empty match with its slots
+    template <class TChar>
+    class TTaggedNFAGenerator
+    {
+        typedef std::vector<unsigned> TTags;
+
+        // target of a hole
+        static const unsigned Exit = static_cast<unsigned>(-1);
+        static const unsigned NoHole = static_cast<unsigned>(-1);
+
+        // continuation with slots set on the way
+        struct TItem
+        {
+            unsigned Target;
+            TTags Tags;
+
+            inline TItem(unsigned target = Exit, const TTags& tags = TTags())
+                : Target(target)
+                , Tags(tags)
+            {
+            }
+        };
+
+        typedef std::vector<TItem> TItems;
+
+        struct TPositions
+        {
+            // ranges entering every position, position i ranges are
+            // [Offsets[i], Offsets[i + 1]) elements of Ranges
+            std::vector<std::pair<TChar, TChar> > Ranges;
+            std::vector<unsigned> Offsets;
+            // continuations of every position and index of its hole
+            std::vector<TItems> Follows;
+            std::vector<unsigned> Holes;
+
+            inline unsigned Count() const
+            {
+                return Follows.size();
+            }
+
+            // new position has nothing but the hole
+            inline void Add()
+            {
+                Offsets.push_back(Ranges.size());
+                Follows.push_back(TItems(1));
+                Holes.push_back(0);
+            }
+        };
+
+        struct TInfo
+        {
+            // starts of node matches in priority order, a hole marks the
+            // preferred empty match, if node can match empty string
+            TItems First;
+            // positions which can end node matches, they have holes
+            std::vector<unsigned> Last;
+        };
+
+        static unsigned FindHole(const TItems& items)
+        {
+            for(unsigned i = 0; i < items.size(); ++i)
+            {
+                if(items[i].Target == Exit)
+                {
+                    return i;
+                }
+            }
+            return NoHole;
+        }
+
+        // items inserted into the hole of list keep its slots
+        static unsigned Fill(TItems& list, unsigned hole,
+            const TItems& items)
+        {
+            const TTags tags = list[hole].Tags;
+            list.insert(list.begin() + hole + 1, items.begin(), items.end());
+            list.erase(list.begin() + hole);
+            for(unsigned i = hole; i < hole + items.size(); ++i)
+            {
+                list[i].Tags.insert(list[i].Tags.begin(), tags.begin(),
+                    tags.end());
+            }
+            const unsigned inner = FindHole(items);
+            return inner == NoHole ? NoHole : hole + inner;
+        }
+
+        // concatenation of left and right is placed into left
+        static void Concatenate(TPositions& positions, TInfo& left,
+            TInfo& right)
+        {
+            std::vector<unsigned> last;
+            for(std::vector<unsigned>::const_iterator position =
+                left.Last.begin(), end = left.Last.end(); position != end;
+                ++position)
+            {
+                unsigned& hole = positions.Holes[*position];
+                hole = Fill(positions.Follows[*position], hole, right.First);
+                if(hole != NoHole)
+                {
+                    last.push_back(*position);
+                }
+            }
+            last.insert(last.end(), right.Last.begin(), right.Last.end());
+            left.Last.swap(last);
+            const unsigned hole = FindHole(left.First);
+            if(hole != NoHole)
+            {
+                Fill(left.First, hole, right.First);
+            }
+        }
+
+        static void Alternate(TInfo& left, const TInfo& right)
+        {
+            // only the preferred empty match is kept
+            const bool nullable = FindHole(left.First) != NoHole;
+            for(typename TItems::const_iterator item = right.First.begin(),
+                end = right.First.end(); item != end; ++item)
+            {
+                if(item->Target != Exit || !nullable)
+                {
+                    left.First.push_back(*item);
+                }
+            }
+            left.Last.insert(left.Last.end(), right.Last.begin(),
+                right.Last.end());
+        }
+
+        static void Capture(TPositions& positions, TInfo& info,
+            unsigned index)
+        {
+            for(typename TItems::iterator item = info.First.begin(),
+                end = info.First.end(); item != end; ++item)
+            {
+                item->Tags.insert(item->Tags.begin(), index * 2);
+                if(item->Target == Exit)
+                {
+                    item->Tags.push_back(index * 2 + 1);
+                }
+            }
+            for(std::vector<unsigned>::const_iterator position =
+                info.Last.begin(), end = info.Last.end(); position != end;
+                ++position)
+            {
+                positions.Follows[*position][positions.Holes[*position]]
+                    .Tags.push_back(index * 2 + 1);
+            }
+        }
+
+        // node can be skipped, which is the least preferred choice, the
+        // preferred empty match of the node keeps its place and slots
+        static void MakeOptional(TInfo& info)
+        {
+            if(FindHole(info.First) == NoHole)
+            {
+                info.First.push_back(TItem());
+            }
+        }
+
+        // node can be repeated, which is preferred to leaving it
+        static void MakeLoop(TPositions& positions, TInfo& info)
+        {
+            TItems loop;
+            for(typename TItems::const_iterator item = info.First.begin(),
+                end = info.First.end(); item != end; ++item)
+            {
+                if(item->Target != Exit)
+                {
+                    loop.push_back(*item);
+                }
+            }
+            loop.push_back(TItem());
+            for(std::vector<unsigned>::const_iterator position =
+                info.Last.begin(), end = info.Last.end(); position != end;
+                ++position)
+            {
+                unsigned& hole = positions.Holes[*position];
+                hole = Fill(positions.Follows[*position], hole, loop);
+            }
+        }
+
+        // info of copy of the node with positions shifted by offset
+        static void Shift(const TInfo& info, unsigned offset, TInfo& result)
+        {
+            result = info;
+            for(unsigned i = 0; i < result.First.size(); ++i)
+            {
+                if(result.First[i].Target != Exit)
+                {
+                    result.First[i].Target += offset;
+                }
+            }
+            for(unsigned i = 0; i < result.Last.size(); ++i)
+            {
+                result.Last[i] += offset;
+            }
+        }
+
+        // same as TNFAGenerator::Repeat, copies set slots of the original
+        static void Repeat(const TRepetition* repetition, unsigned state,
+            TPositions& positions, TInfo& info)
+        {
+            if(!repetition->Max)
+            {
+                info.First.assign(1, TItem());
+                info.Last.clear();
+                return;
+            }
+            const bool unbounded =
+                repetition->Max == TRepetition::Unbounded;
+            const unsigned copies = unbounded
+                ? std::max(repetition->Min, 1u) : repetition->Max;
+            const unsigned size = positions.Count() - state;
+            for(unsigned copy = 1; copy < copies; ++copy)
+            {
+                for(unsigned i = state; i < state + size; ++i)
+                {
+                    for(unsigned range = positions.Offsets[i];
+                        range < positions.Offsets[i + 1]; ++range)
+                    {
+                        const std::pair<TChar, TChar> copied =
+                            positions.Ranges[range];
+                        positions.Ranges.push_back(copied);
+                    }
+                    positions.Add();
+                    TItems follow = positions.Follows[i];
+                    for(unsigned j = 0; j < follow.size(); ++j)
+                    {
+                        if(follow[j].Target != Exit)
+                        {
+                            follow[j].Target += copy * size;
+                        }
+                    }
+                    positions.Follows.back().swap(follow);
+                    positions.Holes.back() = positions.Holes[i];
+                }
+            }
+
+            // built from the last copy backwards
+            TInfo result;
+            Shift(info, (copies - 1) * size, result);
+            if(unbounded)
+            {
+                MakeLoop(positions, result);
+            }
+            if(copies - 1 >= repetition->Min)
+            {
+                MakeOptional(result);
+            }
+            for(unsigned copy = copies - 1; copy-- > 0;)
+            {
+                TInfo left;
+                Shift(info, copy * size, left);
+                Concatenate(positions, left, result);
+                if(copy >= repetition->Min)
+                {
+                    MakeOptional(left);
+                }
+                std::swap(left, result);
+            }
+            std::swap(info, result);
+        }
+
+        // computes pattern info, adds its characters and classes as new
+        // positions, returns the largest capture index
+        static unsigned AddPattern(const INode* root, TPositions& positions,
+            TInfo& result)
+        {
+            unsigned captures = 0;
+            // post-order traversal, second element is true when children
+            // are already processed and their infos are on the top of infos
+            std::vector<std::pair<const INode*, bool> > stack;
+            std::vector<TInfo> infos;
+            // first position of every repetition being processed
+            std::vector<unsigned> repetitions;
+            stack.push_back(std::make_pair(root, false));
+            while(!stack.empty())
+            {
+                const INode* node = stack.back().first;
+                const bool visited = stack.back().second;
+                stack.pop_back();
+                if(node->GetNodeType() == TNodeType::Token)
+                {
+                    infos.push_back(TInfo());
+                    TInfo& info = infos.back();
+                    const TTokenType::TType type =
+                        static_cast<const IToken*>(node)->GetTokenType();
+                    if(type == TTokenType::Empty)
+                    {
+                        info.First.push_back(TItem());
+                        continue;
+                    }
+                    info.First.push_back(TItem(positions.Count()));
+                    info.Last.push_back(positions.Count());
+                    if(type == TTokenType::Character)
+                    {
+                        const TChar character = static_cast<
+                            const TCharacter<TChar>*>(node)->Character;
+                        positions.Ranges.push_back(std::make_pair(character,
+                            character));
+                    }
+                    else
+                    {
+                        const TCharacterClass<TChar>* characterClass =
+                            static_cast<const TCharacterClass<TChar>*>(node);
+                        positions.Ranges.insert(positions.Ranges.end(),
+                            characterClass->Begin(), characterClass->End());
+                    }
+                    positions.Add();
+                    continue;
+                }
+
+                const IOperation* operation =
+                    static_cast<const IOperation*>(node);
+                if(!visited)
+                {
+                    if(operation->GetOperationType()
+                        == TOperationType::Repetition)
+                    {
+                        repetitions.push_back(positions.Count());
+                    }
+                    stack.push_back(std::make_pair(node, true));
+                    for(int i = 1; i >= 0; --i)
+                    {
+                        if(operation->Children[i])
+                        {
+                            stack.push_back(std::make_pair(
+                                operation->Children[i], false));
+                        }
+                    }
+                    continue;
+                }
+
+                switch(operation->GetOperationType())
+                {
+                    case TOperationType::Concatenation:
+                        Concatenate(positions, infos[infos.size() - 2],
+                            infos.back());
+                        infos.pop_back();
+                        break;
+
+                    case TOperationType::Alternation:
+                        Alternate(infos[infos.size() - 2], infos.back());
+                        infos.pop_back();
+                        break;
+
+                    case TOperationType::Closure:
+                        MakeLoop(positions, infos.back());
+                        MakeOptional(infos.back());
+                        break;
+
+                    case TOperationType::Repetition:
+                        Repeat(static_cast<const TRepetition*>(operation),
+                            repetitions.back(), positions, infos.back());
+                        repetitions.pop_back();
+                        break;
+
+                    case TOperationType::Capture:
+                    {
+                        const unsigned index =
+                            static_cast<const TCapture*>(operation)->Index;
+                        Capture(positions, infos.back(), index);
+                        captures = std::max(captures, index);
+                        break;
+                    }
+
+                    default:
+                        throw std::logic_error("unknown operation type");
+                }
+            }
+            std::swap(result, infos.back());
+            return captures;
+        }
+
+    public:
+        // pattern is the whole match, group 0, root must not be null
+        static TTaggedNFA<TChar> CreateNFA(const INode* root)
+        {
+            // position 0 is the start state, it has no incoming transitions
+            TPositions positions;
+            positions.Offsets.push_back(0);
+            positions.Add();
+            TInfo info;
+            const unsigned captures = AddPattern(root, positions, info);
+            Capture(positions, info, 0);
+            positions.Holes[0] = Fill(positions.Follows[0], 0, info.First);
+
+            TTaggedNFA<TChar> result;
+            result.GroupsCount = captures + 1;
+            result.Offsets.assign(1, 0);
+            result.AcceptStates.resize(positions.Count());
+            // source which was the last to enter every state, only the
+            // first transition between two states can be taken
+            std::vector<unsigned> entered(positions.Count(), Exit);
+            // hole tags of accept states
+            std::vector<const TTags*> finals(positions.Count());
+            for(unsigned state = 0; state < positions.Count(); ++state)
+            {
+                const TItems& follow = positions.Follows[state];
+                for(typename TItems::const_iterator item = follow.begin(),
+                    end = follow.end(); item != end; ++item)
+                {
+                    if(item->Target == Exit)
+                    {
+                        result.AcceptStates[state] = true;
+                        finals[state] = &item->Tags;
+                        continue;
+                    }
+                    if(entered[item->Target] == state)
+                    {
+                        continue;
+                    }
+                    entered[item->Target] = state;
+                    const unsigned tagsBegin = result.Tags.size();
+                    result.Tags.insert(result.Tags.end(), item->Tags.begin(),
+                        item->Tags.end());
+                    for(unsigned range = positions.Offsets[item->Target];
+                        range < positions.Offsets[item->Target + 1];
+                        ++range)
+                    {
+                        result.Transitions.push_back(typename
+                            TTaggedNFA<TChar>::TTransition(
+                                positions.Ranges[range].first,
+                                positions.Ranges[range].second,
+                                item->Target, tagsBegin,
+                                result.Tags.size()));
+                    }
+                }
+                result.Offsets.push_back(result.Transitions.size());
+            }
+            result.FinalOffsets.assign(1, result.Tags.size());
+            for(unsigned state = 0; state < positions.Count(); ++state)
+            {
+                if(finals[state])
+                {
+                    result.Tags.insert(result.Tags.end(),
+                        finals[state]->begin(), finals[state]->end());
+                }
+                result.FinalOffsets.push_back(result.Tags.size());
+            }
+            return result;
+        }
+    };
+
+    template <class TChar>
+    const unsigned TTaggedNFAGenerator<TChar>::Exit;
+
+    template <class TChar>
+    const unsigned TTaggedNFAGenerator<TChar>::NoHole;
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef __TEDDY_HPP_2026_10_17__
+#define __TEDDY_HPP_2026_10_17__
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "prefilter.hpp"
+
+namespace NReinventedWheels
+{
+    // finds occurrences of a few literals at once: literals are spread
+    // over 8 buckets, and the first bytes of every position are looked up
+    // by their low and high nibbles in per bucket bit masks, 16 positions
+    // at a time with SSSE3 shuffles, only positions where some bucket
+    // matches all looked up nibbles are verified
+    class TTeddy: public IPrefilter
+    {
+        enum
+        {
+            Buckets = 8,
+            MaxLiterals = 32,
+            // number of leading bytes checked before verification
+            MaxPrefix = 3,
+            Nibbles = 16
+        };
+
+        // ordered, bucket b literals are [BucketOffsets[b],
+        // BucketOffsets[b + 1])
+        std::vector<std::string> Literals;
+        unsigned BucketOffsets[Buckets + 1];
+        std::string::size_type MinLength;
+        unsigned Prefix;
+        // buckets having the nibble value at prefix position
+        unsigned char Low[MaxPrefix][Nibbles];
+        unsigned char High[MaxPrefix][Nibbles];
+
+        // returns buckets with matching prefix at pos
+        inline unsigned char GetBuckets(const char* pos) const
+        {
+            unsigned char result = 0xFF;
+            for(unsigned i = 0; i < Prefix; ++i)
+            {
+                const unsigned char byte = pos[i];
+                result &= Low[i][byte & 0xF] & High[i][byte >> 4];
+            }
+            return result;
+        }
+
+        inline bool Verify(const char* pos, const char* end,
+            unsigned char buckets) const
+        {
+            for(; buckets; buckets &= buckets - 1)
+            {
+                const unsigned bucket = __builtin_ctz(buckets);
+                for(unsigned i = BucketOffsets[bucket];
+                    i < BucketOffsets[bucket + 1]; ++i)
+                {
+                    const std::string& literal = Literals[i];
+                    if(literal.size() <= static_cast<std::string::size_type>(
+                        end - pos)
+                        && !std::memcmp(pos, literal.data(), literal.size()))
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+    public:
+        // there must be a few literals, none of them empty, checking
+        // positions one by one is slower than running an automaton, so
+        // nothing is suitable without vector instructions
+        static bool IsSuitable(const std::vector<std::string>& literals)
+        {
+#if !defined(__SSSE3__)
+            return false;
+#endif
+            if(literals.empty() || literals.size() > MaxLiterals)
+            {
+                return false;
+            }
+            for(std::vector<std::string>::const_iterator literal =
+                literals.begin(), end = literals.end(); literal != end;
+                ++literal)
+            {
+                if(literal->empty())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        TTeddy(const std::vector<std::string>& literals)
+            : Literals(literals)
+        {
+            std::sort(Literals.begin(), Literals.end());
+            Literals.erase(std::unique(Literals.begin(), Literals.end()),
+                Literals.end());
+            MinLength = Literals.front().size();
+            for(std::vector<std::string>::const_iterator literal =
+                Literals.begin(), end = Literals.end(); literal != end;
+                ++literal)
+            {
+                MinLength = std::min(MinLength, literal->size());
+            }
+            Prefix = std::min<std::string::size_type>(MinLength, MaxPrefix);
+
+            // neighbours share prefixes, so they are put into the same
+            // bucket, which keeps masks selective
+            std::fill(Low[0], Low[0] + MaxPrefix * Nibbles, 0);
+            std::fill(High[0], High[0] + MaxPrefix * Nibbles, 0);
+            const unsigned count = Literals.size();
+            for(unsigned bucket = 0; bucket <= Buckets; ++bucket)
+            {
+                BucketOffsets[bucket] = (bucket * count + Buckets - 1)
+                    / Buckets;
+            }
+            for(unsigned bucket = 0; bucket < Buckets; ++bucket)
+            {
+                for(unsigned i = BucketOffsets[bucket];
+                    i < BucketOffsets[bucket + 1]; ++i)
+                {
+                    for(unsigned position = 0; position < Prefix;
+                        ++position)
+                    {
+                        const unsigned char byte = Literals[i][position];
+                        Low[position][byte & 0xF] |= 1 << bucket;
+                        High[position][byte >> 4] |= 1 << bucket;
+                    }
+                }
+            }
+        }
+
+        // returns the start of the first occurrence of any literal or end
+        virtual const char* Find(const char* begin, const char* end) const
+        {
+            if(static_cast<std::string::size_type>(end - begin) < MinLength)
+            {
+                return end;
+            }
+            // last possible literal start
+            const char* last = end - MinLength;
+            const char* pos = begin;
+#if defined(__SSSE3__)
+            const __m128i nibble = _mm_set1_epi8(0xF);
+            __m128i low[MaxPrefix];
+            __m128i high[MaxPrefix];
+            for(unsigned i = 0; i < Prefix; ++i)
+            {
+                low[i] = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(Low[i]));
+                high[i] = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(High[i]));
+            }
+            for(; end - pos >= 16 + MaxPrefix; pos += 16)
+            {
+                __m128i buckets = _mm_set1_epi8(-1);
+                for(unsigned i = 0; i < Prefix; ++i)
+                {
+                    const __m128i input = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(pos + i));
+                    buckets = _mm_and_si128(buckets, _mm_and_si128(
+                        _mm_shuffle_epi8(low[i],
+                            _mm_and_si128(input, nibble)),
+                        _mm_shuffle_epi8(high[i], _mm_and_si128(
+                            _mm_srli_epi16(input, 4), nibble))));
+                }
+                unsigned mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(buckets,
+                    _mm_setzero_si128())) & 0xFFFF;
+                if(!mask)
+                {
+                    continue;
+                }
+                unsigned char found[16];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(found), buckets);
+                for(; mask; mask &= mask - 1)
+                {
+                    const unsigned offset = __builtin_ctz(mask);
+                    if(Verify(pos + offset, end, found[offset]))
+                    {
+                        return pos + offset;
+                    }
+                }
+            }
+#endif
+            // tail or no vector instructions
+            for(; pos <= last; ++pos)
+            {
+                const unsigned char buckets = GetBuckets(pos);
+                if(buckets && Verify(pos, end, buckets))
+                {
+                    return pos;
+                }
+            }
+            return end;
+        }
+    };
+}
+
+#endif
@@ -1,8 +1,14 @@
 #ifndef __TOKEN_HPP_2011_10_11__
 #define __TOKEN_HPP_2011_10_11__
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
+#include <limits>
+#include <new>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace NReinventedWheels
 {
@@ -22,29 +28,147 @@ namespace NReinventedWheels
         }
 
         virtual TNodeType::TType GetNodeType() const = 0;
+
+        static inline void* operator new(std::size_t size)
+        {
+            return ::operator new(size);
+        }
+
+        static inline void operator delete(void* node)
+        {
+            ::operator delete(node);
+        }
+
+        // new (allocator) TNode(...) places node into allocator memory
+        template <class TAllocator>
+        static inline void* operator new(std::size_t size,
+            TAllocator& allocator)
+        {
+            return allocator.Allocate(size);
+        }
+
+        template <class TAllocator>
+        static inline void operator delete(void* node,
+            TAllocator& allocator)
+        {
+            allocator.Deallocate(node);
+        }
+    };
+
+    // every node is allocated separately, tree is released by deleting its
+    // root
+    struct THeapAllocator
+    {
+        inline void* Allocate(std::size_t size)
+        {
+            return ::operator new(size);
+        }
+
+        inline void Deallocate(void* node)
+        {
+            ::operator delete(node);
+        }
+
+        static inline void Release(const INode* node)
+        {
+            delete node;
+        }
     };
 
-    class TNodePtr
+    // bump allocator, nodes are never destroyed one by one, instead all
+    // memory is released at once with the arena, which also avoids
+    // recursive destruction of deep trees
+    class TNodeArena
+    {
+        enum
+        {
+            BlockSize = 4096,
+            Alignment = 16
+        };
+
+        std::vector<char*> Blocks;
+        char* Current;
+        std::size_t Left;
+
+        TNodeArena(const TNodeArena&);
+        TNodeArena& operator = (const TNodeArena&);
+
+    public:
+        inline TNodeArena()
+            : Current(0)
+            , Left(0)
+        {
+        }
+
+        inline ~TNodeArena()
+        {
+            Clear();
+        }
+
+        void* Allocate(std::size_t size)
+        {
+            size = (size + Alignment - 1) & ~static_cast<std::size_t>(
+                Alignment - 1);
+            if(size > Left)
+            {
+                const std::size_t blockSize =
+                    std::max<std::size_t>(size, BlockSize);
+                Blocks.reserve(Blocks.size() + 1);
+                Current = new char[blockSize];
+                Blocks.push_back(Current);
+                Left = blockSize;
+            }
+            void* result = Current;
+            Current += size;
+            Left -= size;
+            return result;
+        }
+
+        inline void Deallocate(void*)
+        {
+        }
+
+        static inline void Release(const INode*)
+        {
+        }
+
+        // invalidates all nodes allocated from this arena
+        void Clear()
+        {
+            for(std::vector<char*>::const_iterator block = Blocks.begin(),
+                end = Blocks.end(); block != end; ++block)
+            {
+                delete[] *block;
+            }
+            Blocks.clear();
+            Current = 0;
+            Left = 0;
+        }
+    };
+
+    // releases node with TAllocator::Release on destruction
+    template <class TAllocator>
+    class TBasicNodePtr
     {
         const INode* Node;
 
-        TNodePtr(const TNodePtr&);
-        TNodePtr& operator = (const TNodePtr&);
+        TBasicNodePtr(const TBasicNodePtr&);
+        TBasicNodePtr& operator = (const TBasicNodePtr&);
 
     public:
-        inline TNodePtr(const INode* node = 0)
+        inline TBasicNodePtr(const INode* node = 0)
             : Node(node)
         {
         }
 
-        inline TNodePtr(TNodePtr& ptr)
+        inline TBasicNodePtr(TBasicNodePtr& ptr)
             : Node(ptr.Release())
         {
         }
 
-        inline ~TNodePtr()
+        inline ~TBasicNodePtr()
         {
-            delete Node;
+            TAllocator::Release(Node);
         }
 
         inline const INode* operator -> () const
@@ -61,7 +185,7 @@ namespace NReinventedWheels
 
         inline void Set(const INode* node)
         {
-            delete Node;
+            TAllocator::Release(Node);
             Node = node;
         }
 
@@ -71,13 +195,17 @@ namespace NReinventedWheels
         }
     };
 
+    typedef TBasicNodePtr<THeapAllocator> TNodePtr;
+
     struct TOperationType
     {
         enum TType
         {
             Concatenation,
             Alternation,
-            Closure
+            Closure,
+            Repetition,
+            Capture
         };
     };
 
@@ -91,10 +219,26 @@ namespace NReinventedWheels
             Children[1] = right;
         }
 
-        inline ~IOperation()
+        // operation children are detached before deletion, so deep trees
+        // are released without recursion
+        ~IOperation()
         {
-            delete Children[0];
-            delete Children[1];
+            std::vector<const INode*> nodes(Children, Children + 2);
+            while(!nodes.empty())
+            {
+                const INode* node = nodes.back();
+                nodes.pop_back();
+                if(node && node->GetNodeType() == TNodeType::Operation)
+                {
+                    IOperation* operation = const_cast<IOperation*>(
+                        static_cast<const IOperation*>(node));
+                    nodes.insert(nodes.end(), operation->Children,
+                        operation->Children + 2);
+                    operation->Children[0] = 0;
+                    operation->Children[1] = 0;
+                }
+                delete node;
+            }
         }
 
         virtual inline TNodeType::TType GetNodeType() const
@@ -144,11 +288,57 @@ namespace NReinventedWheels
         }
     };
 
+    // from Min to Max repetitions of the child
+    struct TRepetition: IOperation
+    {
+        enum
+        {
+            // larger counts are rejected by parser
+            MaxCount = 1000,
+            // Max of repetition without upper bound
+            Unbounded = MaxCount + 1
+        };
+
+        unsigned Min;
+        unsigned Max;
+
+        inline TRepetition(const INode* node, unsigned min, unsigned max)
+            : IOperation(node)
+            , Min(min)
+            , Max(max)
+        {
+        }
+
+        virtual inline TOperationType::TType GetOperationType() const
+        {
+            return TOperationType::Repetition;
+        }
+    };
+
+    // remembers where the child matched, groups are numbered from 1 in
+    // order of their opening brackets, 0 is the whole match
+    struct TCapture: IOperation
+    {
+        unsigned Index;
+
+        inline TCapture(const INode* node, unsigned index)
+            : IOperation(node)
+            , Index(index)
+        {
+        }
+
+        virtual inline TOperationType::TType GetOperationType() const
+        {
+            return TOperationType::Capture;
+        }
+    };
+
     struct TTokenType
     {
         enum TType
         {
             Character,
+            Class,
             Empty
         };
     };
@@ -194,42 +384,164 @@ namespace NReinventedWheels
         return new TCharacter<TChar>(character);
     }
 
+    template <class TChar, class TAllocator>
+    inline TCharacter<TChar>* MakeCharacter(TChar character,
+        TAllocator& allocator)
+    {
+        return new (allocator) TCharacter<TChar>(character);
+    }
+
+    // matches any character from its ranges, ranges are ordered and
+    // neither overlap nor touch each other, they are stored right after the
+    // node in the same allocation, so the node owns no other memory
+    template <class TChar>
+    struct TCharacterClass: IToken
+    {
+        typedef std::pair<TChar, TChar> TRange;
+
+        const unsigned RangesCount;
+
+        inline explicit TCharacterClass(unsigned rangesCount)
+            : RangesCount(rangesCount)
+        {
+        }
+
+        inline const TRange* Begin() const
+        {
+            return reinterpret_cast<const TRange*>(this + 1);
+        }
+
+        inline const TRange* End() const
+        {
+            return Begin() + RangesCount;
+        }
+
+        virtual inline TTokenType::TType GetTokenType() const
+        {
+            return TTokenType::Class;
+        }
+    };
+
+    // sorts ranges and merges overlapping and adjacent ones
+    template <class TChar>
+    void NormalizeRanges(std::vector<std::pair<TChar, TChar> >& ranges)
+    {
+        if(ranges.empty())
+        {
+            return;
+        }
+        std::sort(ranges.begin(), ranges.end());
+        typename std::vector<std::pair<TChar, TChar> >::iterator last =
+            ranges.begin();
+        for(typename std::vector<std::pair<TChar, TChar> >::iterator range =
+            last + 1, end = ranges.end(); range != end; ++range)
+        {
+            if(!(last->second < range->first)
+                || (last->second != std::numeric_limits<TChar>::max()
+                    && static_cast<TChar>(last->second + 1) == range->first))
+            {
+                last->second = std::max(last->second, range->second);
+            }
+            else
+            {
+                *++last = *range;
+            }
+        }
+        ranges.erase(last + 1, ranges.end());
+    }
+
+    // replaces normalized ranges with their complement
+    template <class TChar>
+    void InvertRanges(std::vector<std::pair<TChar, TChar> >& ranges)
+    {
+        std::vector<std::pair<TChar, TChar> > result;
+        TChar first = std::numeric_limits<TChar>::min();
+        bool tail = true;
+        for(typename std::vector<std::pair<TChar, TChar> >::const_iterator
+            range = ranges.begin(), end = ranges.end(); range != end;
+            ++range)
+        {
+            if(first < range->first)
+            {
+                result.push_back(std::make_pair(first,
+                    static_cast<TChar>(range->first - 1)));
+            }
+            tail = range->second != std::numeric_limits<TChar>::max();
+            first = static_cast<TChar>(range->second + 1);
+        }
+        if(tail)
+        {
+            result.push_back(std::make_pair(first,
+                std::numeric_limits<TChar>::max()));
+        }
+        ranges.swap(result);
+    }
+
+    // ranges must be normalized
+    template <class TChar, class TAllocator>
+    TCharacterClass<TChar>* MakeCharacterClass(
+        const std::vector<std::pair<TChar, TChar> >& ranges,
+        TAllocator& allocator)
+    {
+        typedef typename TCharacterClass<TChar>::TRange TRange;
+        void* memory = INode::operator new(sizeof(TCharacterClass<TChar>)
+            + ranges.size() * sizeof(TRange), allocator);
+        TCharacterClass<TChar>* result =
+            ::new (memory) TCharacterClass<TChar>(ranges.size());
+        std::copy(ranges.begin(), ranges.end(),
+            const_cast<TRange*>(result->Begin()));
+        return result;
+    }
+
+    template <class TChar>
+    inline TCharacterClass<TChar>* MakeCharacterClass(
+        const std::vector<std::pair<TChar, TChar> >& ranges)
+    {
+        THeapAllocator allocator;
+        return MakeCharacterClass(ranges, allocator);
+    }
+
     struct TSymbolType
     {
         enum TType {
             EOL,
             Asterisk,
+            Plus,
+            QuestionMark,
+            OpeningBrace,
             Pipe,
             OpeningBracket,
             ClosingBracket,
+            OpeningSquareBracket,
+            Dot,
             Character,
             EscapedCharacter
         };
     };
 
-    template <class TReverseIterator>
-    inline TSymbolType::TType GetSymbolType(TReverseIterator rbegin,
-        TReverseIterator rend)
+    template <class TIterator>
+    inline TSymbolType::TType GetSymbolType(TIterator begin, TIterator end)
     {
-        if (rbegin == rend)
+        if (begin == end)
         {
             return TSymbolType::EOL;
         }
         else
         {
-            TReverseIterator next(rbegin);
-            if (++next != rend)
-            {
-                if (*next == '\\')
-                {
-                    return TSymbolType::EscapedCharacter;
-                }
-            }
-            switch(*rbegin)
+            switch(*begin)
             {
                 case '*':
                     return TSymbolType::Asterisk;
 
+                case '+':
+                    return TSymbolType::Plus;
+
+                case '?':
+                    return TSymbolType::QuestionMark;
+
+                case '{':
+                    return TSymbolType::OpeningBrace;
+
                 case '|':
                     return TSymbolType::Pipe;
 
@@ -239,8 +551,19 @@ namespace NReinventedWheels
                 case ')':
                     return TSymbolType::ClosingBracket;
 
+                case '[':
+                    return TSymbolType::OpeningSquareBracket;
+
+                case '.':
+                    return TSymbolType::Dot;
+
                 case '\\':
-                    throw std::logic_error("unterminated slash character");
+                    if (++begin == end)
+                    {
+                        throw std::logic_error(
+                            "unterminated slash character");
+                    }
+                    return TSymbolType::EscapedCharacter;
 
                 default:
                     return TSymbolType::Character;
@@ -248,141 +571,392 @@ namespace NReinventedWheels
         }
     }
 
-    // begin should point to the closing bracket
-    // return value will point to the opening bracket
-    template <class TReverseIterator>
-    TReverseIterator FindOpeningBracket(TReverseIterator rbegin,
-        TReverseIterator rend)
+    // single pass parser with explicit stack of open groups, so neither time
+    // nor native stack usage depend on nesting
+    // [...] and [^...] are character classes with a-z ranges, . is any
+    // character except newline
+    // (...) is a capture group, (?:...) only groups
+    // x+, x? and x{n}, x{n,}, x{n,m} are repetitions, { starting anything
+    // else is taken literally
+    // closure and repetitions bind tighter than concatenation, which binds
+    // tighter than alternation, both binary operations are left
+    // associative
+    template <class TAllocator>
+    class TParser
     {
-        unsigned depth = 1;
-        for(TSymbolType::TType type = GetSymbolType(++rbegin, rend);
-            type != TSymbolType::EOL && depth;
-            type = GetSymbolType(++rbegin, rend))
+        // group being parsed is Alternation | Sequence Last, where Last is
+        // the only operand closure and repetitions can be applied to, any
+        // part can be null
+        struct TGroup
         {
-            switch(type)
-            {
-                case TSymbolType::OpeningBracket:
-                    --depth;
-                    break;
+            const INode* Alternation;
+            const INode* Sequence;
+            const INode* Last;
+            bool HasPipe;
+            // capture group index, 0 if the group does not capture
+            unsigned Capture;
+        };
 
-                case TSymbolType::ClosingBracket:
-                    ++depth;
-                    break;
+        TAllocator& Allocator;
+        std::vector<TGroup> Groups;
+        unsigned Captures;
 
-                default:
-                    break;
-            }
-        }
+        TParser(const TParser&);
+        TParser& operator = (const TParser&);
 
-        if(depth)
+        inline void OpenGroup(unsigned capture)
         {
-            throw std::logic_error("no suitable closing bracket found");
+            const TGroup group = {0, 0, 0, false, capture};
+            Groups.push_back(group);
         }
-        return rbegin;
-    }
-
-    template <class TReverseIterator>
-    const INode* ParseNode(TReverseIterator rbegin, TReverseIterator rend);
 
-    template <class TReverseIterator>
-    inline const INode* ParseLeftNode(TReverseIterator rbegin,
-        TReverseIterator rend, TNodePtr right)
-    {
-        switch(GetSymbolType(rbegin, rend))
+        // appends operand to the current group
+        void Append(const INode* node)
         {
-            case TSymbolType::EOL:
-            case TSymbolType::OpeningBracket:
-                return right.Release();
-
-            case TSymbolType::Asterisk:
+            TBasicNodePtr<TAllocator> holder(node);
+            TGroup& group = Groups.back();
+            if(group.Last)
             {
-                TNodePtr left(ParseNode(++rbegin, rend));
-                return new TConcatenation(new TClosure(left.Release()),
-                    right.Release());
+                if(group.Sequence)
+                {
+                    group.Sequence = new (Allocator) TConcatenation(
+                        group.Sequence, group.Last);
+                }
+                else
+                {
+                    group.Sequence = group.Last;
+                }
             }
+            group.Last = holder.Release();
+        }
 
-            case TSymbolType::Pipe:
+        // returns the whole sequence, the group is left without it
+        const INode* TakeSequence()
+        {
+            TGroup& group = Groups.back();
+            if(!group.Last)
             {
-                TNodePtr left(ParseNode(++rbegin, rend));
-                return new TAlternation(left.Release(), right.Release());
+                return new (Allocator) TEmpty;
             }
-
-            case TSymbolType::ClosingBracket:
-            case TSymbolType::Character:
-            case TSymbolType::EscapedCharacter:
+            if(group.Sequence)
             {
-                TNodePtr left(ParseNode(rbegin, rend));
-                return new TConcatenation(left.Release(), right.Release());
+                group.Last = new (Allocator) TConcatenation(group.Sequence,
+                    group.Last);
+                group.Sequence = 0;
             }
-
-            default:
-                throw std::logic_error("unknown symbol type");
+            const INode* result = group.Last;
+            group.Last = 0;
+            return result;
         }
-    }
 
-    // TODO: provide ability to pass custom allocator
-    template <class TReverseIterator>
-    const INode* ParseNode(TReverseIterator rbegin, TReverseIterator rend)
-    {
-        switch(GetSymbolType(rbegin, rend))
+        void AddAlternative()
         {
-            case TSymbolType::EOL:
-            case TSymbolType::OpeningBracket:
-                return new TEmpty;
+            TBasicNodePtr<TAllocator> sequence(TakeSequence());
+            TGroup& group = Groups.back();
+            if(group.HasPipe)
+            {
+                group.Alternation = new (Allocator) TAlternation(
+                    group.Alternation, sequence.Get());
+            }
+            else
+            {
+                group.Alternation = sequence.Get();
+                group.HasPipe = true;
+            }
+            sequence.Release();
+        }
 
-            case TSymbolType::Asterisk:
-                return new TClosure(ParseNode(++rbegin, rend));
+        template <class TIterator>
+        static typename std::iterator_traits<TIterator>::value_type
+            ReadClassCharacter(TIterator& begin, TIterator end)
+        {
+            if(*begin == '\\' && ++begin == end)
+            {
+                throw std::logic_error("unterminated slash character");
+            }
+            return *begin++;
+        }
 
-            case TSymbolType::Pipe:
+        // parses [...] or [^...] starting at begin and leaves begin at the
+        // closing bracket, which is taken literally if it goes first
+        // class of a single character becomes that character
+        template <class TIterator>
+        const INode* ParseClass(TIterator& begin, TIterator end)
+        {
+            typedef typename std::iterator_traits<TIterator>::value_type
+                TChar;
+            std::vector<std::pair<TChar, TChar> > ranges;
+            const bool inverted = ++begin != end && *begin == '^';
+            if(inverted)
             {
-                TNodePtr empty(new TEmpty);
-                return ParseLeftNode(rbegin, rend, empty);
+                ++begin;
             }
+            for(bool first = true; first || *begin != ']'; first = false)
+            {
+                if(begin == end)
+                {
+                    throw std::logic_error("unterminated character class");
+                }
+                const TChar low = ReadClassCharacter(begin, end);
+                TChar high = low;
+                TIterator next = begin;
+                if(begin != end && *begin == '-' && ++next != end
+                    && *next != ']')
+                {
+                    begin = next;
+                    high = ReadClassCharacter(begin, end);
+                    if(high < low)
+                    {
+                        throw std::logic_error("invalid character range");
+                    }
+                }
+                ranges.push_back(std::make_pair(low, high));
+                if(begin == end)
+                {
+                    throw std::logic_error("unterminated character class");
+                }
+            }
+            NormalizeRanges(ranges);
+            if(inverted)
+            {
+                InvertRanges(ranges);
+            }
+            if(ranges.size() == 1 && ranges.front().first
+                == ranges.front().second)
+            {
+                return MakeCharacter(ranges.front().first, Allocator);
+            }
+            return MakeCharacterClass(ranges, Allocator);
+        }
 
-            case TSymbolType::ClosingBracket:
+        // reads decimal number, returns false if there are no digits
+        template <class TIterator>
+        static bool ReadCount(TIterator& begin, TIterator end,
+            unsigned& result)
+        {
+            const TIterator start = begin;
+            for(result = 0; begin != end && *begin >= '0' && *begin <= '9';
+                ++begin)
             {
-                TReverseIterator pos = FindOpeningBracket(rbegin, rend);
-                TNodePtr right(ParseNode(++rbegin, pos));
-                if (pos == rend)
+                result = result * 10 + static_cast<unsigned>(*begin - '0');
+                if(result > TRepetition::MaxCount)
                 {
-                    return right.Release();
+                    throw std::logic_error("repetition count is too large");
                 }
-                else
+            }
+            return begin != start;
+        }
+
+        // parses {n}, {n,} or {n,m} starting at begin and leaves begin at
+        // the closing brace, returns false and leaves begin untouched if
+        // there is something else
+        template <class TIterator>
+        static bool ParseBounds(TIterator& begin, TIterator end,
+            unsigned& min, unsigned& max)
+        {
+            TIterator current = begin;
+            if(!ReadCount(++current, end, min))
+            {
+                return false;
+            }
+            max = min;
+            if(current != end && *current == ',')
+            {
+                max = TRepetition::Unbounded;
+                if(++current != end && *current != '}'
+                    && !ReadCount(current, end, max))
                 {
-                    return ParseLeftNode(pos, rend, right);
+                    return false;
                 }
             }
+            if(current == end || *current != '}')
+            {
+                return false;
+            }
+            if(max < min)
+            {
+                throw std::logic_error("invalid repetition bounds");
+            }
+            begin = current;
+            return true;
+        }
+
+        // applies repetition to the last operand of the current group
+        void Repeat(unsigned min, unsigned max)
+        {
+            TGroup& group = Groups.back();
+            if(!group.Last)
+            {
+                group.Last = new (Allocator) TEmpty;
+            }
+            group.Last = new (Allocator) TRepetition(group.Last, min, max);
+        }
 
-            case TSymbolType::Character:
+        // any character except newline
+        template <class TChar>
+        const INode* MakeDot()
+        {
+            std::vector<std::pair<TChar, TChar> > ranges(1,
+                std::make_pair(TChar('\n'), TChar('\n')));
+            InvertRanges(ranges);
+            return MakeCharacterClass(ranges, Allocator);
+        }
+
+        // removes the current group and returns its tree
+        const INode* CloseGroup()
+        {
+            if(Groups.back().HasPipe)
             {
-                TNodePtr right(MakeCharacter(*rbegin));
-                return ParseLeftNode(++rbegin, rend, right);
+                AddAlternative();
             }
+            else
+            {
+                Groups.back().Alternation = TakeSequence();
+            }
+            if(Groups.back().Capture)
+            {
+                Groups.back().Alternation = new (Allocator) TCapture(
+                    Groups.back().Alternation, Groups.back().Capture);
+            }
+            const INode* result = Groups.back().Alternation;
+            Groups.pop_back();
+            return result;
+        }
 
-            case TSymbolType::EscapedCharacter:
+    public:
+        inline TParser(TAllocator& allocator)
+            : Allocator(allocator)
+            , Captures(0)
+        {
+        }
+
+        // releases everything parsed before an error
+        ~TParser()
+        {
+            for(typename std::vector<TGroup>::const_iterator group =
+                Groups.begin(), end = Groups.end(); group != end; ++group)
             {
-                TNodePtr right(MakeCharacter(*rbegin));
-                return ParseLeftNode(++++rbegin, rend, right);
+                TAllocator::Release(group->Alternation);
+                TAllocator::Release(group->Sequence);
+                TAllocator::Release(group->Last);
             }
+        }
 
-            default:
-                throw std::logic_error("unknown symbol type");
+        template <class TIterator>
+        const INode* Parse(TIterator begin, TIterator end)
+        {
+            OpenGroup(0);
+            for(TSymbolType::TType type; (type = GetSymbolType(begin, end))
+                != TSymbolType::EOL; ++begin)
+            {
+                switch(type)
+                {
+                    case TSymbolType::Asterisk:
+                    {
+                        TGroup& group = Groups.back();
+                        if(!group.Last)
+                        {
+                            group.Last = new (Allocator) TEmpty;
+                        }
+                        group.Last = new (Allocator) TClosure(group.Last);
+                        break;
+                    }
+
+                    case TSymbolType::Plus:
+                        Repeat(1, TRepetition::Unbounded);
+                        break;
+
+                    case TSymbolType::QuestionMark:
+                        Repeat(0, 1);
+                        break;
+
+                    case TSymbolType::OpeningBrace:
+                    {
+                        unsigned min;
+                        unsigned max;
+                        if(ParseBounds(begin, end, min, max))
+                        {
+                            Repeat(min, max);
+                        }
+                        else
+                        {
+                            Append(MakeCharacter(*begin, Allocator));
+                        }
+                        break;
+                    }
+
+                    case TSymbolType::Pipe:
+                        AddAlternative();
+                        break;
+
+                    case TSymbolType::OpeningBracket:
+                    {
+                        TIterator next = begin;
+                        if(++next != end && *next == '?' && ++next != end
+                            && *next == ':')
+                        {
+                            begin = next;
+                            OpenGroup(0);
+                        }
+                        else
+                        {
+                            OpenGroup(++Captures);
+                        }
+                        break;
+                    }
+
+                    case TSymbolType::ClosingBracket:
+                        if(Groups.size() == 1)
+                        {
+                            throw std::logic_error(
+                                "no suitable opening bracket found");
+                        }
+                        Append(CloseGroup());
+                        break;
+
+                    case TSymbolType::OpeningSquareBracket:
+                        Append(ParseClass(begin, end));
+                        break;
+
+                    case TSymbolType::Dot:
+                        Append(MakeDot<typename
+                            std::iterator_traits<TIterator>::value_type>());
+                        break;
+
+                    case TSymbolType::EscapedCharacter:
+                        Append(MakeCharacter(*++begin, Allocator));
+                        break;
+
+                    case TSymbolType::Character:
+                        Append(MakeCharacter(*begin, Allocator));
+                        break;
+
+                    default:
+                        throw std::logic_error("unknown symbol type");
+                }
+            }
+            if(Groups.size() != 1)
+            {
+                throw std::logic_error("no suitable closing bracket found");
+            }
+            return CloseGroup();
         }
-    }
+    };
 
-    template <class TBidirectionalIterator>
-    inline std::reverse_iterator<TBidirectionalIterator> MakeReverseIterator(
-        TBidirectionalIterator iterator)
+    // nodes are placed into allocator, the result is either released by
+    // deleting the root for THeapAllocator or together with TNodeArena
+    template <class TIterator, class TAllocator>
+    inline const INode* Parse(TIterator begin, TIterator end,
+        TAllocator& allocator)
     {
-        return std::reverse_iterator<TBidirectionalIterator>(iterator);
+        return TParser<TAllocator>(allocator).Parse(begin, end);
     }
 
-    template <class TBidirectionalIterator>
-    inline const INode* Parse(TBidirectionalIterator begin,
-        TBidirectionalIterator end)
+    template <class TIterator>
+    inline const INode* Parse(TIterator begin, TIterator end)
     {
-        return ParseNode(MakeReverseIterator(end),
-            MakeReverseIterator(begin));
+        THeapAllocator allocator;
+        return Parse(begin, end, allocator);
     }
 }
 
@@ -0,0 +1,453 @@
+#ifndef __UTF8_HPP_2026_10_17__
+#define __UTF8_HPP_2026_10_17__
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "token.hpp"
+
+namespace NReinventedWheels
+{
+    // decodes UTF-8 string into code points, throws on malformed input
+    template <class TChar>
+    void DecodeUtf8(const char* begin, const char* end,
+        std::vector<TChar>& result)
+    {
+        while(begin != end)
+        {
+            const unsigned char lead = *begin++;
+            unsigned length = 0;
+            unsigned long codePoint = lead;
+            unsigned long min = 0;
+            if(lead >= 0xF0 && lead <= 0xF4)
+            {
+                length = 3;
+                codePoint = lead & 0x07;
+                min = 0x10000;
+            }
+            else if(lead >= 0xE0 && lead < 0xF0)
+            {
+                length = 2;
+                codePoint = lead & 0x0F;
+                min = 0x800;
+            }
+            else if(lead >= 0xC2 && lead < 0xE0)
+            {
+                length = 1;
+                codePoint = lead & 0x1F;
+                min = 0x80;
+            }
+            else if(lead >= 0x80)
+            {
+                throw std::logic_error("invalid UTF-8 sequence");
+            }
+            for(; length; --length)
+            {
+                if(begin == end
+                    || (static_cast<unsigned char>(*begin) & 0xC0) != 0x80)
+                {
+                    throw std::logic_error("invalid UTF-8 sequence");
+                }
+                codePoint = codePoint << 6
+                    | (static_cast<unsigned char>(*begin++) & 0x3F);
+            }
+            if(codePoint < min || codePoint > 0x10FFFF
+                || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            {
+                throw std::logic_error("invalid UTF-8 sequence");
+            }
+            result.push_back(static_cast<TChar>(codePoint));
+        }
+    }
+
+    // converts tree over code points into tree over UTF-8 bytes, so byte
+    // automata scan UTF-8 input without decoding it
+    // every code point range becomes an alternation of byte range
+    // sequences, sequences sharing suffixes share their positions, so a
+    // class costs a few positions per encoded length
+    // surrogates and code points out of Unicode are never matched
+    template <class TChar, class TAllocator>
+    class TUtf8Compiler
+    {
+        typedef std::pair<unsigned char, unsigned char> TByteRange;
+        typedef std::vector<TByteRange> TSequence;
+
+        enum
+        {
+            MaxCodePoint = 0x10FFFF,
+            MaxLength = 4
+        };
+
+        // trie of reversed sequences, node 0 is the root
+        struct TSuffixNode
+        {
+            std::map<TByteRange, unsigned> Children;
+            // some sequence starts here
+            bool Start;
+        };
+
+        TAllocator& Allocator;
+
+        static unsigned Encode(unsigned long codePoint,
+            unsigned char* bytes)
+        {
+            if(codePoint < 0x80)
+            {
+                bytes[0] = codePoint;
+                return 1;
+            }
+            if(codePoint < 0x800)
+            {
+                bytes[0] = 0xC0 | codePoint >> 6;
+                bytes[1] = 0x80 | (codePoint & 0x3F);
+                return 2;
+            }
+            if(codePoint < 0x10000)
+            {
+                bytes[0] = 0xE0 | codePoint >> 12;
+                bytes[1] = 0x80 | (codePoint >> 6 & 0x3F);
+                bytes[2] = 0x80 | (codePoint & 0x3F);
+                return 3;
+            }
+            bytes[0] = 0xF0 | codePoint >> 18;
+            bytes[1] = 0x80 | (codePoint >> 12 & 0x3F);
+            bytes[2] = 0x80 | (codePoint >> 6 & 0x3F);
+            bytes[3] = 0x80 | (codePoint & 0x3F);
+            return 4;
+        }
+
+        // splits [first, last] into ranges whose encodings differ in the
+        // last bytes only by covering all continuation bytes, each of them
+        // is a single sequence of byte ranges
+        static void Split(unsigned long first, unsigned long last,
+            std::vector<TSequence>& result)
+        {
+            static const unsigned long limits[] = {0x7F, 0x7FF, 0xFFFF};
+            std::vector<std::pair<unsigned long, unsigned long> > stack(1,
+                std::make_pair(first, last));
+            while(!stack.empty())
+            {
+                first = stack.back().first;
+                last = stack.back().second;
+                stack.pop_back();
+                if(first < 0xD800 && last > 0xDFFF)
+                {
+                    stack.push_back(std::make_pair(0xE000ul, last));
+                    stack.push_back(std::make_pair(first, 0xD7FFul));
+                    continue;
+                }
+                if(first >= 0xD800 && first <= 0xDFFF)
+                {
+                    first = 0xE000;
+                }
+                if(last >= 0xD800 && last <= 0xDFFF)
+                {
+                    last = 0xD7FF;
+                }
+                if(first > last)
+                {
+                    continue;
+                }
+
+                // both ends must have the same encoded length
+                bool split = false;
+                for(unsigned i = 0; i < 3 && !split; ++i)
+                {
+                    if(first <= limits[i] && last > limits[i])
+                    {
+                        stack.push_back(std::make_pair(limits[i] + 1, last));
+                        stack.push_back(std::make_pair(first, limits[i]));
+                        split = true;
+                    }
+                }
+                // ends must differ in the leading bytes only, trailing
+                // bytes must span all continuation values
+                for(unsigned i = 1; i < MaxLength && !split; ++i)
+                {
+                    const unsigned long mask = (1ul << 6 * i) - 1;
+                    if((first & ~mask) == (last & ~mask))
+                    {
+                        continue;
+                    }
+                    if(first & mask)
+                    {
+                        stack.push_back(std::make_pair((first | mask) + 1,
+                            last));
+                        stack.push_back(std::make_pair(first,
+                            first | mask));
+                        split = true;
+                    }
+                    else if((last & mask) != mask)
+                    {
+                        stack.push_back(std::make_pair(last & ~mask, last));
+                        stack.push_back(std::make_pair(first,
+                            (last & ~mask) - 1));
+                        split = true;
+                    }
+                }
+                if(split)
+                {
+                    continue;
+                }
+                unsigned char low[MaxLength];
+                unsigned char high[MaxLength];
+                const unsigned length = Encode(first, low);
+                Encode(last, high);
+                result.push_back(TSequence());
+                for(unsigned i = 0; i < length; ++i)
+                {
+                    result.back().push_back(TByteRange(low[i], high[i]));
+                }
+            }
+        }
+
+        const INode* MakeByteRange(const TByteRange& range)
+        {
+            if(range.first == range.second)
+            {
+                return MakeCharacter(static_cast<char>(range.first),
+                    Allocator);
+            }
+            return MakeCharacterClass(std::vector<std::pair<char, char> >(1,
+                std::make_pair(static_cast<char>(range.first),
+                    static_cast<char>(range.second))), Allocator);
+        }
+
+        // alternation of all sequences leading to the trie node, followed
+        // by the node suffix
+        const INode* MakeSuffix(const std::vector<TSuffixNode>& nodes,
+            unsigned node)
+        {
+            TBasicNodePtr<TAllocator> result(nodes[node].Start
+                ? new (Allocator) TEmpty : 0);
+            for(typename std::map<TByteRange, unsigned>::const_iterator
+                child = nodes[node].Children.begin(),
+                end = nodes[node].Children.end(); child != end; ++child)
+            {
+                TBasicNodePtr<TAllocator> prefix(
+                    MakeSuffix(nodes, child->second));
+                TBasicNodePtr<TAllocator> byte(MakeByteRange(child->first));
+                TBasicNodePtr<TAllocator> sequence(
+                    new (Allocator) TConcatenation(prefix.Get(), byte.Get()));
+                prefix.Release();
+                byte.Release();
+                const INode* alternation = sequence.Get();
+                if(result.Get())
+                {
+                    alternation = new (Allocator) TAlternation(result.Get(),
+                        sequence.Get());
+                    result.Release();
+                }
+                sequence.Release();
+                result.Set(alternation);
+            }
+            return result.Release();
+        }
+
+        // tree matching one code point from ranges, nothing if there are
+        // no valid code points in them
+        const INode* MakeRanges(
+            const std::vector<std::pair<TChar, TChar> >& ranges)
+        {
+            std::vector<TSequence> sequences;
+            for(typename std::vector<std::pair<TChar, TChar> >::
+                const_iterator range = ranges.begin(), end = ranges.end();
+                range != end; ++range)
+            {
+                if(range->second < TChar())
+                {
+                    continue;
+                }
+                const unsigned long first = range->first < TChar()
+                    ? 0 : static_cast<unsigned long>(range->first);
+                const unsigned long last = std::min<unsigned long>(
+                    range->second, MaxCodePoint);
+                if(first <= last)
+                {
+                    Split(first, last, sequences);
+                }
+            }
+            if(sequences.empty())
+            {
+                return MakeCharacterClass(
+                    std::vector<std::pair<char, char> >(), Allocator);
+            }
+
+            std::vector<TSuffixNode> nodes(1);
+            nodes.front().Start = false;
+            for(typename std::vector<TSequence>::const_iterator sequence =
+                sequences.begin(), end = sequences.end(); sequence != end;
+                ++sequence)
+            {
+                unsigned node = 0;
+                for(typename TSequence::const_reverse_iterator byte =
+                    sequence->rbegin(); byte != sequence->rend(); ++byte)
+                {
+                    const std::pair<typename std::map<TByteRange,
+                        unsigned>::iterator, bool> child =
+                        nodes[node].Children.insert(std::make_pair(*byte,
+                            nodes.size()));
+                    node = child.first->second;
+                    if(child.second)
+                    {
+                        nodes.push_back(TSuffixNode());
+                        nodes.back().Start = false;
+                    }
+                }
+                nodes[node].Start = true;
+            }
+            return MakeSuffix(nodes, 0);
+        }
+
+        const INode* Convert(const IToken* token)
+        {
+            switch(token->GetTokenType())
+            {
+                case TTokenType::Character:
+                {
+                    const TChar character = static_cast<
+                        const TCharacter<TChar>*>(token)->Character;
+                    return MakeRanges(std::vector<std::pair<TChar, TChar> >(
+                        1, std::make_pair(character, character)));
+                }
+
+                case TTokenType::Class:
+                {
+                    const TCharacterClass<TChar>* characterClass =
+                        static_cast<const TCharacterClass<TChar>*>(token);
+                    return MakeRanges(std::vector<std::pair<TChar, TChar> >(
+                        characterClass->Begin(), characterClass->End()));
+                }
+
+                case TTokenType::Empty:
+                    return new (Allocator) TEmpty;
+
+                default:
+                    throw std::logic_error("unknown token type");
+            }
+        }
+
+    public:
+        inline TUtf8Compiler(TAllocator& allocator)
+            : Allocator(allocator)
+        {
+        }
+
+        // the result is a new tree placed into allocator, original tree
+        // is left untouched
+        const INode* Compile(const INode* root)
+        {
+            // post-order traversal, second element is true when children
+            // are already converted and their trees are on the top of
+            // results
+            std::vector<std::pair<const INode*, bool> > stack;
+            std::vector<const INode*> results;
+            stack.push_back(std::make_pair(root, false));
+            try
+            {
+                while(!stack.empty())
+                {
+                    const INode* node = stack.back().first;
+                    const bool visited = stack.back().second;
+                    stack.pop_back();
+                    if(node->GetNodeType() == TNodeType::Token)
+                    {
+                        results.push_back(0);
+                        results.back() =
+                            Convert(static_cast<const IToken*>(node));
+                        continue;
+                    }
+
+                    const IOperation* operation =
+                        static_cast<const IOperation*>(node);
+                    if(!visited)
+                    {
+                        stack.push_back(std::make_pair(node, true));
+                        for(int i = 1; i >= 0; --i)
+                        {
+                            if(operation->Children[i])
+                            {
+                                stack.push_back(std::make_pair(
+                                    operation->Children[i], false));
+                            }
+                        }
+                        continue;
+                    }
+
+                    switch(operation->GetOperationType())
+                    {
+                        case TOperationType::Concatenation:
+                            results[results.size() - 2] = new (Allocator)
+                                TConcatenation(results[results.size() - 2],
+                                    results.back());
+                            results.pop_back();
+                            break;
+
+                        case TOperationType::Alternation:
+                            results[results.size() - 2] = new (Allocator)
+                                TAlternation(results[results.size() - 2],
+                                    results.back());
+                            results.pop_back();
+                            break;
+
+                        case TOperationType::Closure:
+                            results.back() = new (Allocator)
+                                TClosure(results.back());
+                            break;
+
+                        case TOperationType::Repetition:
+                        {
+                            const TRepetition* repetition =
+                                static_cast<const TRepetition*>(operation);
+                            results.back() = new (Allocator)
+                                TRepetition(results.back(),
+                                    repetition->Min, repetition->Max);
+                            break;
+                        }
+
+                        case TOperationType::Capture:
+                            results.back() = new (Allocator) TCapture(
+                                results.back(), static_cast<
+                                    const TCapture*>(operation)->Index);
+                            break;
+
+                        default:
+                            throw std::logic_error(
+                                "unknown operation type");
+                    }
+                }
+            }
+            catch(...)
+            {
+                for(std::vector<const INode*>::const_iterator result =
+                    results.begin(), end = results.end(); result != end;
+                    ++result)
+                {
+                    TAllocator::Release(*result);
+                }
+                throw;
+            }
+            return results.back();
+        }
+    };
+
+    // node are placed into allocator like Parse does
+    template <class TChar, class TAllocator>
+    inline const INode* CompileUtf8(const INode* root,
+        TAllocator& allocator)
+    {
+        return TUtf8Compiler<TChar, TAllocator>(allocator).Compile(root);
+    }
+
+    template <class TChar>
+    inline const INode* CompileUtf8(const INode* root)
+    {
+        THeapAllocator allocator;
+        return CompileUtf8<TChar>(root, allocator);
+    }
+}
+
+#endif